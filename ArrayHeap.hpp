@@ -0,0 +1,299 @@
+#ifndef ARRAY_HEAP_HPP
+#define ARRAY_HEAP_HPP
+
+#include <vector>
+#include <stack>
+#include <functional>
+#include <stdexcept>
+#include <SFML/Graphics.hpp>
+#include "Tree.hpp"
+#include "KaryHeap.hpp"
+#include "TreeDrawing.hpp"
+
+namespace ariel {
+
+    // Implicit K-ary heap - the keys live in one contiguous array in BFS order and the
+    // parent / child positions are computed: the children of index i are K*i+1 ... K*i+K.
+    // No pointers are stored per node, so a heap of n keys takes n * sizeof(T) bytes.
+    // Offers the same BFS / DFS iterators and draw() as Tree.
+    // 'Compare' follows std::make_heap - std::greater<T> (default) gives a min-heap.
+    template <typename T, size_t K = 2, typename Compare = std::greater<T>>
+    class ArrayHeap {
+    public:
+        ArrayHeap(Compare comp = Compare());  // Constructor - empty heap
+        template <typename InputIt>
+        ArrayHeap(InputIt first, InputIt last, Compare comp = Compare());  // Constructor - heapify a range of keys, O(n)
+        explicit ArrayHeap(Tree<T, K>& tree, Compare comp = Compare());  // Constructor - heapify the keys of a tree, O(n)
+
+        void push(const T& key);  // Insert a key, O(log n)
+        T pop_min();  // Remove and return the top key, O(log n)
+        const T& peek() const;  // Return the top key
+        void decrease_key(size_t index, const T& key);  // Move the key at a BFS index up in priority, O(log n)
+
+        size_t size() const;  // Number of keys
+        bool empty() const;  // True if there are no keys
+        const T& key_at(size_t index) const;  // Key at a BFS index
+        const std::vector<T>& keys() const;  // The underlying array in BFS order
+
+        static size_t parent(size_t index);  // BFS index of the parent
+        static size_t child(size_t index, size_t i);  // BFS index of the i-th child
+
+        void draw(sf::RenderTarget& window) const;  // Draw the heap as a tree
+
+        // Iterator classes
+        class BFSIterator;  // Breadth First Search Iterator
+        class DFSIterator;  // Depth First Search Iterator
+
+        BFSIterator begin_bfs() const;  // Begin BFS Iterator
+        BFSIterator end_bfs() const;  // End BFS Iterator
+        DFSIterator begin_dfs() const;  // Begin DFS Iterator
+        DFSIterator end_dfs() const;  // End DFS Iterator
+
+    private:
+        std::vector<T> heap;  // Keys in BFS order
+        Compare comp;  // Comparison function
+
+        // View of the array for the shared drawing functions (TreeDrawing.hpp)
+        struct IndexView {
+            typedef size_t Handle;
+            static const size_t arity = K;
+            const std::vector<T>* heap;
+
+            explicit IndexView(const std::vector<T>* heap) : heap(heap) {}
+            Handle root() const { return 0; }
+            bool valid(Handle index) const { return index < heap->size(); }
+            Handle child(Handle index, size_t i) const { return ArrayHeap::child(index, i); }
+            const T& key(Handle index) const { return (*heap)[index]; }
+        };
+        mutable TreeRenderer<IndexView> renderer;  // Vertex arrays and labels kept between frames
+    };
+
+    // BFSIterator - walks the array in order
+    template <typename T, size_t K, typename Compare>
+    class ArrayHeap<T, K, Compare>::BFSIterator {
+    public:
+        BFSIterator(const std::vector<T>* heap, size_t index);  // BFSIterator constructor
+
+        // Overloaded operators
+        bool operator!=(const BFSIterator& other) const;  // Not equal operator
+        const T& operator*() const;  // Dereference operator
+        BFSIterator& operator++();  // Increment operator
+
+    private:
+        const std::vector<T>* heap;  // The heap array
+        size_t index;  // Current BFS index
+    };
+
+    // DFSIterator - nodes by discovery time, children from left to right
+    template <typename T, size_t K, typename Compare>
+    class ArrayHeap<T, K, Compare>::DFSIterator {
+    public:
+        DFSIterator(const std::vector<T>* heap, bool atBegin);  // DFSIterator constructor
+
+        // Overloaded operators
+        bool operator!=(const DFSIterator& other) const;  // Not equal operator
+        const T& operator*() const;  // Dereference operator
+        DFSIterator& operator++();  // Increment operator
+
+    private:
+        const std::vector<T>* heap;  // The heap array
+        std::stack<size_t> stack;  // Stack of BFS indices according to DFS
+    };
+
+
+    // ********** Implementations **********
+
+
+    // Constructor - empty heap
+    template <typename T, size_t K, typename Compare>
+    ArrayHeap<T, K, Compare>::ArrayHeap(Compare comp) : comp(comp) {}
+
+    // Constructor - copy the keys and arrange them as a heap
+    template <typename T, size_t K, typename Compare>
+    template <typename InputIt>
+    ArrayHeap<T, K, Compare>::ArrayHeap(InputIt first, InputIt last, Compare comp) : heap(first, last), comp(comp) {
+        make_kary_heap<K>(heap.begin(), heap.end(), comp);
+    }
+
+    // Constructor - copy the keys of the tree (BFS order) and arrange them as a heap
+    template <typename T, size_t K, typename Compare>
+    ArrayHeap<T, K, Compare>::ArrayHeap(Tree<T, K>& tree, Compare comp) : comp(comp) {
+        heap.reserve(tree.size());
+        for (auto it = tree.begin_bfs(); it != tree.end_bfs(); ++it) {
+            heap.push_back(*it);
+        }
+        make_kary_heap<K>(heap.begin(), heap.end(), comp);
+    }
+
+    // Insert a key - append it and sift it up
+    template <typename T, size_t K, typename Compare>
+    void ArrayHeap<T, K, Compare>::push(const T& key) {
+        heap.push_back(key);
+        push_kary_heap<K>(heap.begin(), heap.end(), comp);
+        renderer.invalidate();
+    }
+
+    // Remove and return the top key - swap it with the last key, shrink and sift down
+    template <typename T, size_t K, typename Compare>
+    T ArrayHeap<T, K, Compare>::pop_min() {
+        if (heap.empty()) {
+            throw std::out_of_range("Heap is empty");
+        }
+        pop_kary_heap<K>(heap.begin(), heap.end(), comp);
+        T top = std::move(heap.back());
+        heap.pop_back();
+        renderer.invalidate();
+        return top;
+    }
+
+    // Return the top key
+    template <typename T, size_t K, typename Compare>
+    const T& ArrayHeap<T, K, Compare>::peek() const {
+        if (heap.empty()) {
+            throw std::out_of_range("Heap is empty");
+        }
+        return heap.front();
+    }
+
+    // Replace the key at a BFS index with a key of higher (or equal) priority and sift it up
+    template <typename T, size_t K, typename Compare>
+    void ArrayHeap<T, K, Compare>::decrease_key(size_t index, const T& key) {
+        if (index >= heap.size()) {
+            throw std::out_of_range("Heap index out of range");
+        }
+        if (comp(key, heap[index])) {
+            throw std::invalid_argument("New key has lower priority than the current key");
+        }
+        heap[index] = key;
+        sift_up_kary<K>(heap.begin(), index, comp);
+    }
+
+    // Get the number of keys
+    template <typename T, size_t K, typename Compare>
+    size_t ArrayHeap<T, K, Compare>::size() const {
+        return heap.size();
+    }
+
+    // Check if the heap is empty
+    template <typename T, size_t K, typename Compare>
+    bool ArrayHeap<T, K, Compare>::empty() const {
+        return heap.empty();
+    }
+
+    // Get the key at a BFS index
+    template <typename T, size_t K, typename Compare>
+    const T& ArrayHeap<T, K, Compare>::key_at(size_t index) const {
+        return heap.at(index);
+    }
+
+    // Get the underlying array
+    template <typename T, size_t K, typename Compare>
+    const std::vector<T>& ArrayHeap<T, K, Compare>::keys() const {
+        return heap;
+    }
+
+    // Parent of index i is (i - 1) / K
+    template <typename T, size_t K, typename Compare>
+    size_t ArrayHeap<T, K, Compare>::parent(size_t index) {
+        return (index - 1) / K;
+    }
+
+    // The i-th child of index j is K*j + 1 + i
+    template <typename T, size_t K, typename Compare>
+    size_t ArrayHeap<T, K, Compare>::child(size_t index, size_t i) {
+        return K * index + 1 + i;
+    }
+
+    // Function to draw the heap in the specified SFML window - same layout as Tree::draw
+    template <typename T, size_t K, typename Compare>
+    void ArrayHeap<T, K, Compare>::draw(sf::RenderTarget& window) const {
+        renderer.draw(window, IndexView(&heap));
+    }
+
+    // Define the start point of BFS - index 0
+    template <typename T, size_t K, typename Compare>
+    typename ArrayHeap<T, K, Compare>::BFSIterator ArrayHeap<T, K, Compare>::begin_bfs() const {
+        return BFSIterator(&heap, 0);
+    }
+
+    // Define the end point of BFS - one past the last index
+    template <typename T, size_t K, typename Compare>
+    typename ArrayHeap<T, K, Compare>::BFSIterator ArrayHeap<T, K, Compare>::end_bfs() const {
+        return BFSIterator(&heap, heap.size());
+    }
+
+    // Define the start point of DFS - the root
+    template <typename T, size_t K, typename Compare>
+    typename ArrayHeap<T, K, Compare>::DFSIterator ArrayHeap<T, K, Compare>::begin_dfs() const {
+        return DFSIterator(&heap, true);
+    }
+
+    // Define the end point of DFS - empty stack
+    template <typename T, size_t K, typename Compare>
+    typename ArrayHeap<T, K, Compare>::DFSIterator ArrayHeap<T, K, Compare>::end_dfs() const {
+        return DFSIterator(&heap, false);
+    }
+
+    // BFSIterator constructor
+    template <typename T, size_t K, typename Compare>
+    ArrayHeap<T, K, Compare>::BFSIterator::BFSIterator(const std::vector<T>* heap, size_t index) : heap(heap), index(index) {}
+
+    // Not equal operator - main purpose to check it != end_bfs()
+    template <typename T, size_t K, typename Compare>
+    bool ArrayHeap<T, K, Compare>::BFSIterator::operator!=(const BFSIterator& other) const {
+        return index != other.index || heap != other.heap;
+    }
+
+    // Dereference operator - return the key at the current index
+    template <typename T, size_t K, typename Compare>
+    const T& ArrayHeap<T, K, Compare>::BFSIterator::operator*() const {
+        return (*heap)[index];
+    }
+
+    // Increment operator - BFS order is the array order
+    template <typename T, size_t K, typename Compare>
+    typename ArrayHeap<T, K, Compare>::BFSIterator& ArrayHeap<T, K, Compare>::BFSIterator::operator++() {
+        ++index;
+        return *this;
+    }
+
+    // DFSIterator constructor - start with the root on the stack
+    template <typename T, size_t K, typename Compare>
+    ArrayHeap<T, K, Compare>::DFSIterator::DFSIterator(const std::vector<T>* heap, bool atBegin) : heap(heap) {
+        if (atBegin && !heap->empty()) {
+            stack.push(0);
+        }
+    }
+
+    // Not equal operator - mostly for iterator to check if it != end_dfs()
+    template <typename T, size_t K, typename Compare>
+    bool ArrayHeap<T, K, Compare>::DFSIterator::operator!=(const DFSIterator& other) const {
+        return stack != other.stack;
+    }
+
+    // Dereference operator - return the key of the top index in the stack
+    template <typename T, size_t K, typename Compare>
+    const T& ArrayHeap<T, K, Compare>::DFSIterator::operator*() const {
+        return (*heap)[stack.top()];
+    }
+
+    // Increment operator - pop the top index and push its children in reverse order
+    // so the leftmost child is visited first (same order as Tree::DFSIterator)
+    template <typename T, size_t K, typename Compare>
+    typename ArrayHeap<T, K, Compare>::DFSIterator& ArrayHeap<T, K, Compare>::DFSIterator::operator++() {
+        if (!stack.empty()) {
+            size_t current = stack.top();
+            stack.pop();
+            for (size_t i = K; i-- > 0;) {
+                size_t next = ArrayHeap::child(current, i);
+                if (next < heap->size()) {
+                    stack.push(next);
+                }
+            }
+        }
+        return *this;
+    }
+
+}
+
+#endif
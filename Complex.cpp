@@ -1,124 +1,15 @@
 #include "Complex.hpp"
 #include <cmath>
 #include <sstream>
-
-// Constructor
-// constructor with parameters - set the real and imaginary parts to the given parameters
-// if no parameters are given, set the real and imaginary parts to 0 - defined in hpp file
-Complex::Complex(const double& re, const double& im) : _re(re), _im(im) {}
-
-// Getters
-// return the real part of the complex number
-double Complex::re() const {
-    return _re;
-}
-
-// return the imaginary part of the complex number
-double Complex::im() const {
-    return _im;
-}
-// !a
-// ! - Logical NOT: is the real number == 0 and the imaginary number == 0
-bool Complex::operator!() const {
-    return _re == 0 && _im == 0;
-}
-
-//a = -b
-// Unary minus - return a new complex number with the real and imaginary parts negated
-Complex Complex::operator-() const {
-    return Complex(-_re, -_im);
-}
-
-// a+=b
-// Plus equals - add the real and imaginary parts of the given complex number to the current complex number
-Complex& Complex::operator+=(const Complex& other) {
-    _re += other._re;
-    _im += other._im;
-    return *this;
-}
-
-// a -= b
-// Minus equals - subtract the real and imaginary parts of the given complex number from the current complex number
-Complex& Complex::operator-=(const Complex& other) {
-    _re -= other._re;
-    _im -= other._im;
-    return *this;
-}
-
-// a *= b
-// Multiply equals - multiply the real and imaginary parts of the given complex number from the current complex number
-Complex& Complex::operator*=(const Complex& other) {
-    // (a+bi)*(c+di) = (ac - bd) + (ad + bc)i, new_re = (ac -bd), new_im = (ad + bc)
-    double new_re = _re * other._re - _im * other._im;
-    double new_im = _re * other._im + _im * other._re;
-    _re = new_re;
-    _im = new_im;
-    return *this;
-}
-
-// Prefix increment - increment the real part of the complex number
-// & - return a reference to the current complex number
-Complex& Complex::operator++() {
-    _re++;
-    return *this;
-}
-
-// Postfix increment - increment the real part of the complex number and return a copy of the original complex number
-// int - dummy parameter to differentiate between prefix and postfix increment
-Complex Complex::operator++(int) {
-    Complex copy = *this;
-    _re++;
-    return copy;
-}
-
-// Binary minus a - b
-// Operator - return a new complex number with the real and imaginary parts subtracted
-Complex Complex::operator-(const Complex& other) {
-    return Complex(_re - other._re, _im - other._im);
-}
-
-// Binary plus a + b
-// Operator + return a new complex number with the real and imaginary parts added
-Complex Complex::operator+(const Complex &other)
-{
-    return Complex(_re + other._re, _im + other._im);
-}
-
-// Multiply - a * b
-// Operator * return a new complex number with the real and imaginary parts multiplied
-Complex Complex::operator*(const Complex& other) {
-    // (a+bi)*(c+di) = (ac - bd) + (ad + bc)i
-    return Complex(_re * other._re - _im * other._im,
-                   _re * other._im + _im * other._re);
-}
-
-// hypot is a function in the cmath library that returns the hypotenuse of 
-// the square root of the sum of the squares of the real and imaginary parts
-// sqrt(a^2 + b^2) < sqrt(c^2 + d^2)
-bool Complex::operator<(const Complex& other) const {
-    return std::hypot(_re, _im) < std::hypot(other._re, other._im);
-}
-
-// ==
-bool Complex::operator==(const Complex& other) {
-    return this->im() == other.im() && this->re() == other.re();  // check imaginary and real parts equality
-}
-
-// >
-bool Complex::operator>(const Complex& other) const {
-    return (!(*this < other) && !(this == &other)); // using NOT(<) and NOT(==) operators
-}
-
-//  !=
-bool Complex::operator!=(const Complex& other) {
-    return !(*this == other); // using NOT(==) operator
-}
+#include <charconv>
+#include <algorithm>
 
 // Friend global IO operators
 // stream output operator
 // using friend to access the private members of the class ostream
 // and to define that the stream to be on the left-hand side - std::cout << c1
-std::ostream& operator<<(std::ostream& output, const Complex& c) {
+template <typename F>
+std::ostream& operator<<(std::ostream& output, const BasicComplex<F>& c) {
     output << c._re << (c._im >= 0 ? '+' : '-') << std::abs(c._im) << 'i';
     return output;
 }
@@ -126,8 +17,9 @@ std::ostream& operator<<(std::ostream& output, const Complex& c) {
 // stream input operator 
 // using friend to access the private members of the class istream
 // and to define that the stream to be on the left-hand side - std::cin >> c1
-std::istream& operator>>(std::istream& input, Complex& c) {
-    double re = 0, im = 0;
+template <typename F>
+std::istream& operator>>(std::istream& input, BasicComplex<F>& c) {
+    F re = 0, im = 0;
     char ch1, ch2;
 
     if (input >> re >> ch1 >> im >> ch2 && ch2 == 'i') {
@@ -146,4 +38,119 @@ std::istream& operator>>(std::istream& input, Complex& c) {
     }
 
     return input;
-}
\ No newline at end of file
+}
+
+// The stream operators are compiled here once for the two scalar types
+template std::ostream& operator<< <double>(std::ostream& output, const BasicComplex<double>& c);
+template std::ostream& operator<< <float>(std::ostream& output, const BasicComplex<float>& c);
+template std::istream& operator>> <double>(std::istream& input, BasicComplex<double>& c);
+template std::istream& operator>> <float>(std::istream& input, BasicComplex<float>& c);
+
+// ********** Bulk text IO **********
+
+namespace {
+    // Whitespace between literals - same set as std::isspace in the "C" locale
+    inline bool isSeparator(char ch) {
+        return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f';
+    }
+
+    // Parse one literal occupying exactly [first, last) - same grammar as operator>> without the inner spaces:
+    // real part, '+' or '-', imaginary part, 'i'
+    bool parseLiteral(const char* first, const char* last, Complex& value) {
+        double re = 0, im = 0;
+        if (first != last && *first == '+') {
+            ++first;  // from_chars does not take a leading '+'
+        }
+        std::from_chars_result result = std::from_chars(first, last, re);
+        if (result.ec != std::errc() || result.ptr == last) {
+            return false;
+        }
+        char sign = *result.ptr;
+        if (sign != '+' && sign != '-') {
+            return false;  // not + - chars as expected
+        }
+        result = std::from_chars(result.ptr + 1, last, im);
+        if (result.ec != std::errc() || result.ptr + 1 != last || *result.ptr != 'i') {
+            return false;  // not i char as expected
+        }
+        value = Complex(re, sign == '+' ? im : -im);
+        return true;
+    }
+
+    // Write one double - shortest round trip text, or printf "%.*g" text for a precision
+    inline char* writeDouble(char* first, char* last, double value, int precision) {
+        std::to_chars_result result = precision < 0
+            ? std::to_chars(first, last, value)
+            : std::to_chars(first, last, value, std::chars_format::general, precision);
+        return result.ptr;
+    }
+}
+
+// Parse the buffer literal by literal
+// A literal that does not parse is recorded by its offset and skipped up to the next whitespace
+void parse_complex_buffer(const char* data, size_t size, ComplexParseResult& result, bool lastChunk) {
+    const char* current = data;
+    const char* end = data + size;
+    result.consumed = 0;
+    while (true) {
+        while (current != end && isSeparator(*current)) {
+            ++current;
+        }
+        if (current == end) {
+            result.consumed = size;
+            return;
+        }
+        const char* tokenEnd = current;
+        while (tokenEnd != end && !isSeparator(*tokenEnd)) {
+            ++tokenEnd;
+        }
+        if (tokenEnd == end && !lastChunk) {
+            result.consumed = current - data;  // the literal may continue in the next chunk
+            return;
+        }
+        Complex value;
+        if (parseLiteral(current, tokenEnd, value)) {
+            result.values.push_back(value);
+        } else {
+            result.errors.push_back(current - data);
+        }
+        current = tokenEnd;
+    }
+}
+
+// Parse a whole string
+ComplexParseResult parse_complex_buffer(const std::string& text) {
+    ComplexParseResult result;
+    parse_complex_buffer(text.data(), text.size(), result);
+    return result;
+}
+
+// Format the values into a local block and append the block to 'out' when it is nearly full
+void format_complex_buffer(const Complex* values, size_t count, std::string& out, int precision, char separator) {
+    // "%.*g" needs at most precision + 8 chars (sign, point, exponent), the shortest form at most 24
+    const size_t maxLength = 2 * (precision < 0 ? 24 : static_cast<size_t>(precision) + 8) + 3;
+    std::vector<char> block(std::max<size_t>(1 << 16, 4 * maxLength));
+    char* blockEnd = block.data() + block.size();
+    char* current = block.data();
+
+    for (size_t i = 0; i < count; ++i) {
+        if (static_cast<size_t>(blockEnd - current) < maxLength) {
+            out.append(block.data(), current);
+            current = block.data();
+        }
+        double im = values[i].im();
+        current = writeDouble(current, blockEnd, values[i].re(), precision);
+        *current++ = im >= 0 ? '+' : '-';
+        current = writeDouble(current, blockEnd, std::abs(im), precision);
+        *current++ = 'i';
+        *current++ = separator;
+    }
+    out.append(block.data(), current);
+}
+
+// Format a vector of values into a new string
+std::string format_complex_buffer(const std::vector<Complex>& values, int precision, char separator) {
+    std::string out;
+    format_complex_buffer(values.data(), values.size(), out, precision, separator);
+    return out;
+}
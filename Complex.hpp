@@ -1,42 +1,314 @@
 #pragma once
 
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <functional>
 
-class Complex {
+// The arithmetic and comparison operators are defined inline and constexpr in this header,
+// so key comparisons in the heap algorithms and arithmetic in reductions can be inlined and vectorized.
+// Complex.cpp holds only the stream operators (instantiated for float and double) and the bulk text IO.
+// BasicComplex<F> is a complex number over the scalar type F: Complex (double, 16 bytes) is the default,
+// FloatComplex (float, 8 bytes) halves the key memory when float precision is enough.
+template <typename F>
+class BasicComplex;
+
+template <typename F>
+std::ostream& operator<<(std::ostream& output, const BasicComplex<F>& c);  // global output operator
+template <typename F>
+std::istream& operator>>(std::istream& input, BasicComplex<F>& c);  // global input operator
+
+template <typename F>
+class BasicComplex {
 private:
-    double _re;
-    double _im;
+    F _re;
+    F _im;
 
 public:
-    Complex(const double& re = 0.0, const double& im = 0.0); // Constructor.
+    constexpr BasicComplex(const F& re = F(0), const F& im = F(0)); // Constructor.
+    template <typename G>
+    explicit constexpr BasicComplex(const BasicComplex<G>& other); // Conversion from another scalar type
 
-    double re() const; //get the real part of the complex number
-    double im() const; //get the imaginary part of the complex number
+    constexpr F re() const; //get the real part of the complex number
+    constexpr F im() const; //get the imaginary part of the complex number
+    constexpr F norm() const; //get the squared magnitude re^2 + im^2 (like std::norm), cheap key for ordering by magnitude
 
     // Unary operators
-    bool operator!() const; // Logical NOT
-    Complex operator-() const; // Unary minus
+    constexpr bool operator!() const; // Logical NOT
+    constexpr BasicComplex operator-() const; // Unary minus
 
     // Binary operators
-    Complex& operator+=(const Complex& other);  // Plus +=
-    Complex& operator-=(const Complex& other);  // Minus -=
-    Complex& operator*=(const Complex& other);  // Multiply *=
-    Complex& operator++();  // prefix increment
-    Complex operator++(int);  // postfix increment
-    Complex operator-(const Complex& other);  // Binary minus - 
-    Complex operator+(const Complex& other);  // Binary minus +
-    Complex operator*(const Complex& other);  // Multiply *
-
-    // Comparison operators
-    bool operator<(const Complex& other) const;
-    bool operator>(const Complex& other) const;
-    bool operator==(const Complex& other);  
-    bool operator!=(const Complex& other);  
+    constexpr BasicComplex& operator+=(const BasicComplex& other);  // Plus +=
+    constexpr BasicComplex& operator-=(const BasicComplex& other);  // Minus -=
+    constexpr BasicComplex& operator*=(const BasicComplex& other);  // Multiply *=
+    constexpr BasicComplex& operator++();  // prefix increment
+    constexpr BasicComplex operator++(int);  // postfix increment
+    constexpr BasicComplex operator-(const BasicComplex& other) const;  // Binary minus - 
+    constexpr BasicComplex operator+(const BasicComplex& other) const;  // Binary minus +
+    constexpr BasicComplex operator*(const BasicComplex& other) const;  // Multiply *
+
+    // Comparison operators - < and > order by magnitude, compared through the squared magnitude (no square root)
+    constexpr bool operator<(const BasicComplex& other) const;
+    constexpr bool operator>(const BasicComplex& other) const;
+    constexpr bool operator==(const BasicComplex& other) const;  
+    constexpr bool operator!=(const BasicComplex& other) const;  
 
 
     // friend global IO operators
-    friend std::ostream& operator<<(std::ostream& output, const Complex& c);  // global output operator
-    friend std::istream& operator>>(std::istream& input, Complex& c);  // global input operator
+    friend std::ostream& operator<< <>(std::ostream& output, const BasicComplex& c);  // global output operator
+    friend std::istream& operator>> <>(std::istream& input, BasicComplex& c);  // global input operator
 
+private:
+    constexpr bool lessScaled(const BasicComplex& other) const;  // magnitude comparison for norms out of the F range
 };
 
+typedef BasicComplex<double> Complex;  // double precision complex number - the default key type
+typedef BasicComplex<float> FloatComplex;  // single precision complex number
+
+// Constructor
+// constructor with parameters - set the real and imaginary parts to the given parameters
+// if no parameters are given, set the real and imaginary parts to 0 - defined in the declaration
+template <typename F>
+constexpr BasicComplex<F>::BasicComplex(const F& re, const F& im) : _re(re), _im(im) {}
+
+// Conversion - convert both parts to F
+template <typename F>
+template <typename G>
+constexpr BasicComplex<F>::BasicComplex(const BasicComplex<G>& other) : _re(static_cast<F>(other.re())), _im(static_cast<F>(other.im())) {}
+
+// Getters
+// return the real part of the complex number
+template <typename F>
+constexpr F BasicComplex<F>::re() const {
+    return _re;
+}
+
+// return the imaginary part of the complex number
+template <typename F>
+constexpr F BasicComplex<F>::im() const {
+    return _im;
+}
+
+// return the squared magnitude of the complex number - re^2 + im^2
+// orders numbers by magnitude like hypot, without the square root
+template <typename F>
+constexpr F BasicComplex<F>::norm() const {
+    return _re * _re + _im * _im;
+}
+
+// !a
+// ! - Logical NOT: is the real number == 0 and the imaginary number == 0
+template <typename F>
+constexpr bool BasicComplex<F>::operator!() const {
+    return _re == 0 && _im == 0;
+}
+
+//a = -b
+// Unary minus - return a new complex number with the real and imaginary parts negated
+template <typename F>
+constexpr BasicComplex<F> BasicComplex<F>::operator-() const {
+    return BasicComplex(-_re, -_im);
+}
+
+// a+=b
+// Plus equals - add the real and imaginary parts of the given complex number to the current complex number
+template <typename F>
+constexpr BasicComplex<F>& BasicComplex<F>::operator+=(const BasicComplex& other) {
+    _re += other._re;
+    _im += other._im;
+    return *this;
+}
+
+// a -= b
+// Minus equals - subtract the real and imaginary parts of the given complex number from the current complex number
+template <typename F>
+constexpr BasicComplex<F>& BasicComplex<F>::operator-=(const BasicComplex& other) {
+    _re -= other._re;
+    _im -= other._im;
+    return *this;
+}
+
+// a *= b
+// Multiply equals - multiply the real and imaginary parts of the given complex number from the current complex number
+template <typename F>
+constexpr BasicComplex<F>& BasicComplex<F>::operator*=(const BasicComplex& other) {
+    // (a+bi)*(c+di) = (ac - bd) + (ad + bc)i, new_re = (ac -bd), new_im = (ad + bc)
+    F new_re = _re * other._re - _im * other._im;
+    F new_im = _re * other._im + _im * other._re;
+    _re = new_re;
+    _im = new_im;
+    return *this;
+}
+
+// Prefix increment - increment the real part of the complex number
+// & - return a reference to the current complex number
+template <typename F>
+constexpr BasicComplex<F>& BasicComplex<F>::operator++() {
+    _re++;
+    return *this;
+}
+
+// Postfix increment - increment the real part of the complex number and return a copy of the original complex number
+// int - dummy parameter to differentiate between prefix and postfix increment
+template <typename F>
+constexpr BasicComplex<F> BasicComplex<F>::operator++(int) {
+    BasicComplex copy = *this;
+    _re++;
+    return copy;
+}
+
+// Binary minus a - b
+// Operator - return a new complex number with the real and imaginary parts subtracted
+template <typename F>
+constexpr BasicComplex<F> BasicComplex<F>::operator-(const BasicComplex& other) const {
+    return BasicComplex(_re - other._re, _im - other._im);
+}
+
+// Binary plus a + b
+// Operator + return a new complex number with the real and imaginary parts added
+template <typename F>
+constexpr BasicComplex<F> BasicComplex<F>::operator+(const BasicComplex&other) const
+{
+    return BasicComplex(_re + other._re, _im + other._im);
+}
+
+// Multiply - a * b
+// Operator * return a new complex number with the real and imaginary parts multiplied
+template <typename F>
+constexpr BasicComplex<F> BasicComplex<F>::operator*(const BasicComplex& other) const {
+    // (a+bi)*(c+di) = (ac - bd) + (ad + bc)i
+    return BasicComplex(_re * other._re - _im * other._im,
+                   _re * other._im + _im * other._re);
+}
+
+// Compare by magnitude: sqrt(a^2 + b^2) < sqrt(c^2 + d^2) is the same as a^2 + b^2 < c^2 + d^2
+// so the squared magnitudes are compared - no square root and no std::hypot call.
+// Overflow handling: a squared magnitude overflows to infinity when a part is above ~1.3e154 and
+// underflows below ~1.5e-154 (where two different magnitudes could compare equal) - ~1.8e19 and ~1.1e-19
+// for float. When either norm is outside the normal range of F, both numbers are scaled by their largest part first,
+// the same way std::hypot avoids overflow, so the order stays exact for every finite input.
+// A zero norm against a normal one is still compared directly (a norm that underflowed to zero is smaller than any
+// normal norm too), so only denormal, overflowed and NaN norms - and two zero norms - take the scaled path.
+template <typename F>
+constexpr bool BasicComplex<F>::operator<(const BasicComplex& other) const {
+    F lhs = norm();
+    F rhs = other.norm();
+    bool lhsDirect = lhs == 0 || (lhs >= std::numeric_limits<F>::min() && lhs <= std::numeric_limits<F>::max());
+    bool rhsDirect = rhs == 0 || (rhs >= std::numeric_limits<F>::min() && rhs <= std::numeric_limits<F>::max());
+    if (lhsDirect && rhsDirect && (lhs != 0 || rhs != 0)) {
+        return lhs < rhs;
+    }
+    return lessScaled(other);
+}
+
+// Magnitude comparison with both numbers divided by the largest absolute part of the two
+// After scaling every part is in [-1, 1], so the squared magnitudes cannot overflow
+// (a part small enough to underflow belongs to a number at least 1e150 times smaller)
+template <typename F>
+constexpr bool BasicComplex<F>::lessScaled(const BasicComplex& other) const {
+    F scale = 0;
+    const F parts[] = {_re, _im, other._re, other._im};
+    for (F part : parts) {
+        F magnitude = part < 0 ? -part : part;
+        if (magnitude > scale) scale = magnitude;
+    }
+    if (scale == 0) return false;  // both zero
+    if (scale > std::numeric_limits<F>::max()) {  // infinite parts - infinity is larger than any finite magnitude
+        bool lhsInfinite = _re == scale || _re == -scale || _im == scale || _im == -scale;
+        bool rhsInfinite = other._re == scale || other._re == -scale || other._im == scale || other._im == -scale;
+        return !lhsInfinite && rhsInfinite;
+    }
+    BasicComplex lhs(_re / scale, _im / scale);
+    BasicComplex rhs(other._re / scale, other._im / scale);
+    return lhs.norm() < rhs.norm();
+}
+
+// ==
+template <typename F>
+constexpr bool BasicComplex<F>::operator==(const BasicComplex& other) const {
+    return this->im() == other.im() && this->re() == other.re();  // check imaginary and real parts equality
+}
+
+// >
+// a > b is b < a - numbers with equal magnitude are neither < nor >
+template <typename F>
+constexpr bool BasicComplex<F>::operator>(const BasicComplex& other) const {
+    return other < *this;
+}
+
+//  !=
+template <typename F>
+constexpr bool BasicComplex<F>::operator!=(const BasicComplex& other) const {
+    return !(*this == other); // using NOT(==) operator
+}
+
+// Complex number with its squared magnitude computed once at construction
+// Ordering keys (heapify, sort) compare the cached norm only - 24 bytes instead of 16 per key (12 instead of 8 for float).
+// Values are exact for norms inside the range of F; use BasicComplex when parts may exceed ~1e154 (~1e19 for float).
+template <typename F>
+class BasicNormedComplex {
+private:
+    BasicComplex<F> _value;
+    F _norm;
+
+public:
+    constexpr BasicNormedComplex(const BasicComplex<F>& value = BasicComplex<F>()) : _value(value), _norm(value.norm()) {}  // Constructor
+
+    constexpr const BasicComplex<F>& value() const { return _value; }  // get the complex number
+    constexpr F norm() const { return _norm; }  // get the cached squared magnitude
+    constexpr operator const BasicComplex<F>&() const { return _value; }  // use as a BasicComplex
+
+    // Comparison operators - < and > use the cached norm
+    constexpr bool operator<(const BasicNormedComplex& other) const { return _norm < other._norm; }
+    constexpr bool operator>(const BasicNormedComplex& other) const { return other._norm < _norm; }
+    constexpr bool operator==(const BasicNormedComplex& other) const { return _value == other._value; }
+    constexpr bool operator!=(const BasicNormedComplex& other) const { return _value != other._value; }
+
+    // output operator - prints like the complex number
+    friend std::ostream& operator<<(std::ostream& output, const BasicNormedComplex& c) { return output << c._value; }
+};
+
+typedef BasicNormedComplex<double> NormedComplex;
+typedef BasicNormedComplex<float> FloatNormedComplex;
+
+// Hash functions - keys for std::unordered_map / Tree::enable_index()
+// Adding 0 turns -0 into +0, so the two zeros that compare equal also hash equal
+namespace std {
+    template <typename F>
+    struct hash<BasicComplex<F>> {
+        size_t operator()(const BasicComplex<F>& c) const {
+            size_t re = hash<F>()(c.re() + F(0));
+            size_t im = hash<F>()(c.im() + F(0));
+            return re ^ (im + 0x9e3779b97f4a7c15ULL + (re << 6) + (re >> 2));  // boost::hash_combine
+        }
+    };
+
+    template <typename F>
+    struct hash<BasicNormedComplex<F>> {
+        size_t operator()(const BasicNormedComplex<F>& c) const {
+            return hash<BasicComplex<F>>()(c.value());
+        }
+    };
+}
+
+// Bulk text IO - std::from_chars / std::to_chars over a whole buffer, no stream or locale per value
+// A literal has the operator<< form "a+bi" / "a-bi" without inner spaces, literals are separated by whitespace.
+struct ComplexParseResult {
+    std::vector<Complex> values;  // parsed values in buffer order
+    std::vector<size_t> errors;  // byte offsets of the literals that could not be parsed (they are skipped)
+    size_t consumed = 0;  // bytes consumed - the start of the next chunk when the buffer is read in chunks
+};
+
+// Parse every literal of the buffer and append to 'result'.
+// With lastChunk == false a literal touching the end of the buffer is left for the next chunk (not consumed).
+void parse_complex_buffer(const char* data, size_t size, ComplexParseResult& result, bool lastChunk = true);
+ComplexParseResult parse_complex_buffer(const std::string& text);  // Parse a whole string
+
+// Append every value to 'out' followed by 'separator'.
+// precision < 0 writes the shortest text that reads back to the same double,
+// precision 6 gives the same text as operator<< with the default stream settings.
+void format_complex_buffer(const Complex* values, size_t count, std::string& out, int precision = -1, char separator = '\n');
+std::string format_complex_buffer(const std::vector<Complex>& values, int precision = -1, char separator = '\n');
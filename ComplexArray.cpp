@@ -0,0 +1,439 @@
+#include "ComplexArray.hpp"
+#include <stdexcept>
+#include <atomic>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMPLEX_ARRAY_X86 1
+#include <immintrin.h>
+#endif
+
+// Constructor - 'size' zeros
+ComplexArray::ComplexArray(size_t size) : _re(size, 0.0), _im(size, 0.0) {}
+
+// Number of values
+size_t ComplexArray::size() const {
+    return _re.size();
+}
+
+// Resize both buffers
+void ComplexArray::resize(size_t size) {
+    _re.resize(size, 0.0);
+    _im.resize(size, 0.0);
+}
+
+// Reserve both buffers
+void ComplexArray::reserve(size_t capacity) {
+    _re.reserve(capacity);
+    _im.reserve(capacity);
+}
+
+// Remove every value
+void ComplexArray::clear() {
+    _re.clear();
+    _im.clear();
+}
+
+// Append a value - the real part to the real buffer, the imaginary part to the imaginary buffer
+void ComplexArray::push_back(const Complex& value) {
+    _re.push_back(value.re());
+    _im.push_back(value.im());
+}
+
+// Get the value at index i
+Complex ComplexArray::operator[](size_t i) const {
+    return Complex(_re[i], _im[i]);
+}
+
+// Set the value at index i
+void ComplexArray::set(size_t i, const Complex& value) {
+    _re[i] = value.re();
+    _im[i] = value.im();
+}
+
+// Buffer getters
+double* ComplexArray::re() {
+    return _re.data();
+}
+
+double* ComplexArray::im() {
+    return _im.data();
+}
+
+const double* ComplexArray::re() const {
+    return _re.data();
+}
+
+const double* ComplexArray::im() const {
+    return _im.data();
+}
+
+
+// ********** Kernels **********
+// Every kernel has a scalar version (also used for the tail that does not fill a vector register),
+// an SSE2 version (2 doubles per register) and an AVX2 version (4 doubles per register).
+// Every version rounds each product and each sum like Complex does (no fused multiply-add), so all backends,
+// and the vector body and the scalar tail of one call, give bit-identical results.
+
+namespace {
+
+    enum class Backend { Scalar, SSE2, AVX2 };
+
+    // Pick the widest instruction set supported by the CPU - checked once
+    Backend detectBackend() {
+#ifdef COMPLEX_ARRAY_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Backend::AVX2;
+        if (__builtin_cpu_supports("sse2")) return Backend::SSE2;
+#endif
+        return Backend::Scalar;
+    }
+
+    // Backend of the kernels - the detected one unless a test forced another with use_backend
+    std::atomic<Backend>& selectedBackend() {
+        static std::atomic<Backend> backend(detectBackend());
+        return backend;
+    }
+
+    Backend activeBackend() {
+        return selectedBackend().load(std::memory_order_relaxed);
+    }
+
+    // Check that the inputs of a kernel have the same size
+    void requireSameSize(const ComplexArray& a, const ComplexArray& b) {
+        if (a.size() != b.size()) {
+            throw std::invalid_argument("ComplexArray sizes do not match");
+        }
+    }
+
+    // ---- Scalar kernels, from index 'begin' ----
+
+    void addScalar(const double* ar, const double* ai, const double* br, const double* bi, double* outr, double* outi, size_t begin, size_t n) {
+        for (size_t i = begin; i < n; ++i) {
+            outr[i] = ar[i] + br[i];
+            outi[i] = ai[i] + bi[i];
+        }
+    }
+
+    // (a+bi)*(c+di) = (ac - bd) + (ad + bc)i
+    void multiplyScalar(const double* ar, const double* ai, const double* br, const double* bi, double* outr, double* outi, size_t begin, size_t n) {
+        for (size_t i = begin; i < n; ++i) {
+            double re = ar[i] * br[i] - ai[i] * bi[i];
+            double im = ar[i] * bi[i] + ai[i] * br[i];
+            outr[i] = re;
+            outi[i] = im;
+        }
+    }
+
+    void multiplyAddScalar(const double* ar, const double* ai, const double* br, const double* bi, double* accr, double* acci, size_t begin, size_t n) {
+        for (size_t i = begin; i < n; ++i) {
+            double re = ar[i] * br[i] - ai[i] * bi[i];
+            double im = ar[i] * bi[i] + ai[i] * br[i];
+            accr[i] += re;
+            acci[i] += im;
+        }
+    }
+
+    void normScalar(const double* ar, const double* ai, double* out, size_t begin, size_t n) {
+        for (size_t i = begin; i < n; ++i) {
+            out[i] = ar[i] * ar[i] + ai[i] * ai[i];
+        }
+    }
+
+    // Continue an argmin search from 'begin' with the best index and norm found so far
+    // Never inlined into the AVX2 kernel, where the compiler could contract the norm into an FMA
+    __attribute__((noinline))
+    size_t argminFrom(const double* ar, const double* ai, size_t begin, size_t n, size_t best, double bestNorm) {
+        for (size_t i = begin; i < n; ++i) {
+            double value = ar[i] * ar[i] + ai[i] * ai[i];
+            if (value < bestNorm) {
+                bestNorm = value;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // Argmin over the whole range - the first value is the initial best, n if the range is empty
+    __attribute__((noinline))
+    size_t argminScalar(const double* ar, const double* ai, size_t n) {
+        if (n == 0) return 0;
+        return argminFrom(ar, ai, 1, n, 0, ar[0] * ar[0] + ai[0] * ai[0]);
+    }
+
+#ifdef COMPLEX_ARRAY_X86
+
+    // ---- SSE2 kernels, 2 values per step ----
+
+    __attribute__((target("sse2")))
+    void addSSE2(const double* ar, const double* ai, const double* br, const double* bi, double* outr, double* outi, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(outr + i, _mm_add_pd(_mm_loadu_pd(ar + i), _mm_loadu_pd(br + i)));
+            _mm_storeu_pd(outi + i, _mm_add_pd(_mm_loadu_pd(ai + i), _mm_loadu_pd(bi + i)));
+        }
+        addScalar(ar, ai, br, bi, outr, outi, i, n);
+    }
+
+    __attribute__((target("sse2")))
+    void multiplySSE2(const double* ar, const double* ai, const double* br, const double* bi, double* outr, double* outi, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d xr = _mm_loadu_pd(ar + i), xi = _mm_loadu_pd(ai + i);
+            __m128d yr = _mm_loadu_pd(br + i), yi = _mm_loadu_pd(bi + i);
+            _mm_storeu_pd(outr + i, _mm_sub_pd(_mm_mul_pd(xr, yr), _mm_mul_pd(xi, yi)));
+            _mm_storeu_pd(outi + i, _mm_add_pd(_mm_mul_pd(xr, yi), _mm_mul_pd(xi, yr)));
+        }
+        multiplyScalar(ar, ai, br, bi, outr, outi, i, n);
+    }
+
+    __attribute__((target("sse2")))
+    void multiplyAddSSE2(const double* ar, const double* ai, const double* br, const double* bi, double* accr, double* acci, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d xr = _mm_loadu_pd(ar + i), xi = _mm_loadu_pd(ai + i);
+            __m128d yr = _mm_loadu_pd(br + i), yi = _mm_loadu_pd(bi + i);
+            __m128d re = _mm_sub_pd(_mm_mul_pd(xr, yr), _mm_mul_pd(xi, yi));
+            __m128d im = _mm_add_pd(_mm_mul_pd(xr, yi), _mm_mul_pd(xi, yr));
+            _mm_storeu_pd(accr + i, _mm_add_pd(_mm_loadu_pd(accr + i), re));
+            _mm_storeu_pd(acci + i, _mm_add_pd(_mm_loadu_pd(acci + i), im));
+        }
+        multiplyAddScalar(ar, ai, br, bi, accr, acci, i, n);
+    }
+
+    __attribute__((target("sse2")))
+    void normSSE2(const double* ar, const double* ai, double* out, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d xr = _mm_loadu_pd(ar + i), xi = _mm_loadu_pd(ai + i);
+            _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(xr, xr), _mm_mul_pd(xi, xi)));
+        }
+        normScalar(ar, ai, out, i, n);
+    }
+
+    // Both lanes keep their own smallest norm and index, reduced at the end like argminAVX2 - the first minimum wins
+    // SSE2 has no blend instruction, so the compare mask selects with and/andnot/or
+    __attribute__((target("sse2")))
+    size_t argminSSE2(const double* ar, const double* ai, size_t n) {
+        if (n < 2 || std::isnan(ar[0] * ar[0] + ai[0] * ai[0])) {  // a NaN first value stays the answer of the scalar loop
+            return argminScalar(ar, ai, n);
+        }
+        __m128d bestNorm = _mm_set1_pd(__builtin_inf());
+        __m128d bestIndex = _mm_set1_pd(0.0);
+        __m128d index = _mm_set_pd(1.0, 0.0);
+        const __m128d step = _mm_set1_pd(2.0);
+
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d xr = _mm_loadu_pd(ar + i), xi = _mm_loadu_pd(ai + i);
+            __m128d value = _mm_add_pd(_mm_mul_pd(xr, xr), _mm_mul_pd(xi, xi));
+            __m128d smaller = _mm_cmplt_pd(value, bestNorm);
+            bestNorm = _mm_or_pd(_mm_and_pd(smaller, value), _mm_andnot_pd(smaller, bestNorm));
+            bestIndex = _mm_or_pd(_mm_and_pd(smaller, index), _mm_andnot_pd(smaller, bestIndex));
+            index = _mm_add_pd(index, step);
+        }
+
+        double norms[2], indices[2];
+        _mm_storeu_pd(norms, bestNorm);
+        _mm_storeu_pd(indices, bestIndex);
+        size_t best = n;
+        double bestValue = __builtin_inf();
+        for (int lane = 0; lane < 2; ++lane) {
+            size_t laneIndex = static_cast<size_t>(indices[lane]);
+            if (norms[lane] < bestValue || (norms[lane] == bestValue && laneIndex < best)) {
+                bestValue = norms[lane];
+                best = laneIndex;
+            }
+        }
+        if (best == n) {  // every norm so far is infinite (or NaN) - fall back to the scalar search
+            return argminScalar(ar, ai, n);
+        }
+        return argminFrom(ar, ai, i, n, best, bestValue);
+    }
+
+    // ---- AVX2 kernels, 4 values per step ----
+
+    __attribute__((target("avx2")))
+    void addAVX2(const double* ar, const double* ai, const double* br, const double* bi, double* outr, double* outi, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(outr + i, _mm256_add_pd(_mm256_loadu_pd(ar + i), _mm256_loadu_pd(br + i)));
+            _mm256_storeu_pd(outi + i, _mm256_add_pd(_mm256_loadu_pd(ai + i), _mm256_loadu_pd(bi + i)));
+        }
+        addScalar(ar, ai, br, bi, outr, outi, i, n);
+    }
+
+    // re = xr*yr - xi*yi, im = xr*yi + xi*yr
+    __attribute__((target("avx2")))
+    void multiplyAVX2(const double* ar, const double* ai, const double* br, const double* bi, double* outr, double* outi, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d xr = _mm256_loadu_pd(ar + i), xi = _mm256_loadu_pd(ai + i);
+            __m256d yr = _mm256_loadu_pd(br + i), yi = _mm256_loadu_pd(bi + i);
+            _mm256_storeu_pd(outr + i, _mm256_sub_pd(_mm256_mul_pd(xr, yr), _mm256_mul_pd(xi, yi)));
+            _mm256_storeu_pd(outi + i, _mm256_add_pd(_mm256_mul_pd(xr, yi), _mm256_mul_pd(xi, yr)));
+        }
+        multiplyScalar(ar, ai, br, bi, outr, outi, i, n);
+    }
+
+    // acc_re += xr*yr - xi*yi and acc_im += xr*yi + xi*yr - the product first, then the sum, like multiplyAddScalar
+    __attribute__((target("avx2")))
+    void multiplyAddAVX2(const double* ar, const double* ai, const double* br, const double* bi, double* accr, double* acci, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d xr = _mm256_loadu_pd(ar + i), xi = _mm256_loadu_pd(ai + i);
+            __m256d yr = _mm256_loadu_pd(br + i), yi = _mm256_loadu_pd(bi + i);
+            __m256d re = _mm256_sub_pd(_mm256_mul_pd(xr, yr), _mm256_mul_pd(xi, yi));
+            __m256d im = _mm256_add_pd(_mm256_mul_pd(xr, yi), _mm256_mul_pd(xi, yr));
+            _mm256_storeu_pd(accr + i, _mm256_add_pd(_mm256_loadu_pd(accr + i), re));
+            _mm256_storeu_pd(acci + i, _mm256_add_pd(_mm256_loadu_pd(acci + i), im));
+        }
+        multiplyAddScalar(ar, ai, br, bi, accr, acci, i, n);
+    }
+
+    __attribute__((target("avx2")))
+    void normAVX2(const double* ar, const double* ai, double* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d xr = _mm256_loadu_pd(ar + i), xi = _mm256_loadu_pd(ai + i);
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(xr, xr), _mm256_mul_pd(xi, xi)));
+        }
+        normScalar(ar, ai, out, i, n);
+    }
+
+    // Every lane keeps its own smallest norm and index, the lanes are reduced at the end
+    // (smallest norm first, then the lowest index, so the result is the first minimum like the scalar loop)
+    // The norm is re*re + im*im rounded the same way as the scalar loop - an FMA would round once and could
+    // break ties between equal norms differently, e.g. between a+bi and b+ai
+    __attribute__((target("avx2")))
+    size_t argminAVX2(const double* ar, const double* ai, size_t n) {
+        if (n < 4 || std::isnan(ar[0] * ar[0] + ai[0] * ai[0])) {  // a NaN first value stays the answer of the scalar loop
+            return argminScalar(ar, ai, n);
+        }
+        __m256d bestNorm = _mm256_set1_pd(__builtin_inf());
+        __m256d bestIndex = _mm256_set1_pd(0.0);
+        __m256d index = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+        const __m256d step = _mm256_set1_pd(4.0);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d xr = _mm256_loadu_pd(ar + i), xi = _mm256_loadu_pd(ai + i);
+            __m256d value = _mm256_add_pd(_mm256_mul_pd(xr, xr), _mm256_mul_pd(xi, xi));
+            __m256d smaller = _mm256_cmp_pd(value, bestNorm, _CMP_LT_OQ);
+            bestNorm = _mm256_blendv_pd(bestNorm, value, smaller);
+            bestIndex = _mm256_blendv_pd(bestIndex, index, smaller);
+            index = _mm256_add_pd(index, step);
+        }
+
+        double norms[4], indices[4];
+        _mm256_storeu_pd(norms, bestNorm);
+        _mm256_storeu_pd(indices, bestIndex);
+        size_t best = n;
+        double bestValue = __builtin_inf();
+        for (int lane = 0; lane < 4; ++lane) {
+            size_t laneIndex = static_cast<size_t>(indices[lane]);
+            if (norms[lane] < bestValue || (norms[lane] == bestValue && laneIndex < best)) {
+                bestValue = norms[lane];
+                best = laneIndex;
+            }
+        }
+        if (best == n) {  // every norm so far is infinite (or NaN) - fall back to the scalar search
+            return argminScalar(ar, ai, n);
+        }
+        return argminFrom(ar, ai, i, n, best, bestValue);
+    }
+
+#endif
+
+}
+
+// out[i] = a[i] + b[i]
+void ComplexArray::add(const ComplexArray& a, const ComplexArray& b, ComplexArray& out) {
+    requireSameSize(a, b);
+    out.resize(a.size());
+    switch (activeBackend()) {
+#ifdef COMPLEX_ARRAY_X86
+        case Backend::AVX2: addAVX2(a.re(), a.im(), b.re(), b.im(), out.re(), out.im(), a.size()); return;
+        case Backend::SSE2: addSSE2(a.re(), a.im(), b.re(), b.im(), out.re(), out.im(), a.size()); return;
+#endif
+        default: addScalar(a.re(), a.im(), b.re(), b.im(), out.re(), out.im(), 0, a.size());
+    }
+}
+
+// out[i] = a[i] * b[i]
+void ComplexArray::multiply(const ComplexArray& a, const ComplexArray& b, ComplexArray& out) {
+    requireSameSize(a, b);
+    out.resize(a.size());
+    switch (activeBackend()) {
+#ifdef COMPLEX_ARRAY_X86
+        case Backend::AVX2: multiplyAVX2(a.re(), a.im(), b.re(), b.im(), out.re(), out.im(), a.size()); return;
+        case Backend::SSE2: multiplySSE2(a.re(), a.im(), b.re(), b.im(), out.re(), out.im(), a.size()); return;
+#endif
+        default: multiplyScalar(a.re(), a.im(), b.re(), b.im(), out.re(), out.im(), 0, a.size());
+    }
+}
+
+// accumulator[i] += a[i] * b[i]
+void ComplexArray::multiply_add(const ComplexArray& a, const ComplexArray& b, ComplexArray& accumulator) {
+    requireSameSize(a, b);
+    requireSameSize(a, accumulator);
+    switch (activeBackend()) {
+#ifdef COMPLEX_ARRAY_X86
+        case Backend::AVX2: multiplyAddAVX2(a.re(), a.im(), b.re(), b.im(), accumulator.re(), accumulator.im(), a.size()); return;
+        case Backend::SSE2: multiplyAddSSE2(a.re(), a.im(), b.re(), b.im(), accumulator.re(), accumulator.im(), a.size()); return;
+#endif
+        default: multiplyAddScalar(a.re(), a.im(), b.re(), b.im(), accumulator.re(), accumulator.im(), 0, a.size());
+    }
+}
+
+// out[i] = re^2 + im^2
+void ComplexArray::norm(const ComplexArray& a, std::vector<double>& out) {
+    out.resize(a.size());
+    switch (activeBackend()) {
+#ifdef COMPLEX_ARRAY_X86
+        case Backend::AVX2: normAVX2(a.re(), a.im(), out.data(), a.size()); return;
+        case Backend::SSE2: normSSE2(a.re(), a.im(), out.data(), a.size()); return;
+#endif
+        default: normScalar(a.re(), a.im(), out.data(), 0, a.size());
+    }
+}
+
+// Index of the first value with the smallest squared magnitude
+// Like Complex::norm(), parts above ~1e154 overflow to infinity and tie with each other
+size_t ComplexArray::argmin_norm(const ComplexArray& a) {
+    switch (activeBackend()) {
+#ifdef COMPLEX_ARRAY_X86
+        case Backend::AVX2: return argminAVX2(a.re(), a.im(), a.size());
+        case Backend::SSE2: return argminSSE2(a.re(), a.im(), a.size());
+#endif
+        default: return argminScalar(a.re(), a.im(), a.size());
+    }
+}
+
+// Instruction set used by the kernels
+const char* ComplexArray::backend() {
+    switch (activeBackend()) {
+        case Backend::AVX2: return "avx2";
+        case Backend::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+// Force an instruction set - only one the CPU supports, so a test can run every kernel the machine has
+bool ComplexArray::use_backend(const std::string& name) {
+    Backend requested;
+    if (name == "avx2") {
+        requested = Backend::AVX2;
+    } else if (name == "sse2") {
+        requested = Backend::SSE2;
+    } else if (name == "scalar") {
+        requested = Backend::Scalar;
+    } else {
+        return false;
+    }
+    if (static_cast<int>(requested) > static_cast<int>(detectBackend())) {
+        return false;
+    }
+    selectedBackend().store(requested, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stack>
+#include <cstddef>
+#include "Complex.hpp"
+
+// Structure-of-arrays storage for many Complex numbers - the real parts and the imaginary parts
+// live in two separate contiguous buffers, so batch kernels load 2 (SSE2) or 4 (AVX2) numbers per instruction.
+// The kernels pick the widest instruction set the CPU supports at run time (AVX2, SSE2, or plain loops).
+class ComplexArray {
+private:
+    std::vector<double> _re;
+    std::vector<double> _im;
+
+public:
+    explicit ComplexArray(size_t size = 0);  // Constructor - 'size' zeros
+    template <typename InputIt>
+    ComplexArray(InputIt first, InputIt last);  // Constructor - copy Complex values from any traversal
+
+    // Copy the keys of a Tree<Complex, K> with a pointer walk (pre-order), no per-node queue
+    template <typename TreeType>
+    static ComplexArray gather(const TreeType& tree);
+
+    size_t size() const;  // Number of values
+    void resize(size_t size);  // Resize both buffers, new values are zero
+    void reserve(size_t capacity);  // Reserve both buffers
+    void clear();  // Remove every value
+    void push_back(const Complex& value);  // Append a value
+    Complex operator[](size_t i) const;  // Get the value at index i
+    void set(size_t i, const Complex& value);  // Set the value at index i
+
+    double* re();  // Real parts buffer
+    double* im();  // Imaginary parts buffer
+    const double* re() const;  // Real parts buffer
+    const double* im() const;  // Imaginary parts buffer
+
+    // Batch kernels - the inputs must have the same size (std::invalid_argument otherwise), outputs are resized
+    static void add(const ComplexArray& a, const ComplexArray& b, ComplexArray& out);  // out[i] = a[i] + b[i]
+    static void multiply(const ComplexArray& a, const ComplexArray& b, ComplexArray& out);  // out[i] = a[i] * b[i]
+    static void multiply_add(const ComplexArray& a, const ComplexArray& b, ComplexArray& accumulator);  // accumulator[i] += a[i] * b[i]
+    static void norm(const ComplexArray& a, std::vector<double>& out);  // out[i] = a[i].norm()
+    static size_t argmin_norm(const ComplexArray& a);  // Index of the first value with the smallest magnitude (size() if empty)
+
+    static const char* backend();  // Instruction set used by the kernels: "avx2", "sse2" or "scalar"
+    static bool use_backend(const std::string& name);  // Force an instruction set the CPU supports (for tests) - false if it does not
+};
+
+// Constructor - copy every value of the range
+template <typename InputIt>
+ComplexArray::ComplexArray(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+        push_back(*first);
+    }
+}
+
+// Gather the keys of a tree - walks the nodes directly with an explicit stack
+template <typename TreeType>
+ComplexArray ComplexArray::gather(const TreeType& tree) {
+    typedef typename TreeType::Node Node;
+    ComplexArray array;
+    array.reserve(tree.size());
+
+    std::stack<const Node*> nodeStack;
+    if (tree.get_root()) {
+        nodeStack.push(tree.get_root());
+    }
+    while (!nodeStack.empty()) {
+        const Node* current = nodeStack.top();
+        nodeStack.pop();
+        array._re.push_back(current->key.re());
+        array._im.push_back(current->key.im());
+        for (size_t i = sizeof(current->children) / sizeof(current->children[0]); i-- > 0;) {
+            if (current->children[i]) {
+                nodeStack.push(current->children[i]);
+            }
+        }
+    }
+    return array;
+}
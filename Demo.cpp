@@ -2,9 +2,96 @@
 #include "Complex.hpp"
 #include <iostream>
 #include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <functional>
 
 using namespace ariel;
 
+// Open a window with the tree and keep it until it is closed
+// Mouse wheel - zoom around the cursor, left button drag or arrow keys - pan, R - reset the view
+// The window is drawn again only when something changed - input that moves the view, a resize, or an edit of the tree
+// by 'edit' (called for the other keys, returns true if it changed the tree). While nothing changes the loop sleeps
+// in waitEvent, and 'framerateLimit' caps the redraws of a continuous input such as a drag (0 - no limit).
+template <typename TreeType>
+void showTree(TreeType& tree, const std::string& title, std::function<bool(sf::Keyboard::Key)> edit = nullptr, unsigned framerateLimit = 60) {
+    sf::RenderWindow window(sf::VideoMode(800, 600), title);
+    window.setFramerateLimit(framerateLimit);
+    sf::View view = window.getDefaultView();
+    float zoom = 1;  // World units per pixel
+    bool dragging = false;
+    sf::Vector2i dragStart;
+    bool dirty = true;  // True when the window must be drawn again
+
+    // Apply an event - returns true if the window must be drawn again
+    auto handle = [&](const sf::Event& event) {
+        if (event.type == sf::Event::Closed) {
+            // Close the window if the close event is triggered
+            window.close();
+        } else if (event.type == sf::Event::Resized) {
+            // Keep the scale - a bigger window shows more of the tree
+            view.setSize(event.size.width * zoom, event.size.height * zoom);
+            return true;
+        } else if (event.type == sf::Event::GainedFocus) {
+            return true;  // the window may have been covered
+        } else if (event.type == sf::Event::MouseWheelScrolled) {
+            // Zoom so the point under the cursor stays in place
+            sf::Vector2i pixel(event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+            sf::Vector2f before = window.mapPixelToCoords(pixel, view);
+            float factor = event.mouseWheelScroll.delta > 0 ? 0.8f : 1.25f;
+            zoom *= factor;
+            view.zoom(factor);
+            sf::Vector2f after = window.mapPixelToCoords(pixel, view);
+            view.move(before - after);
+            return true;
+        } else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            dragging = true;
+            dragStart = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+        } else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left) {
+            dragging = false;
+        } else if (event.type == sf::Event::MouseMoved && dragging) {
+            // Move the view by the distance the cursor moved in world units
+            sf::Vector2i pixel(event.mouseMove.x, event.mouseMove.y);
+            view.move(window.mapPixelToCoords(dragStart, view) - window.mapPixelToCoords(pixel, view));
+            dragStart = pixel;
+            return true;
+        } else if (event.type == sf::Event::KeyPressed) {
+            float step = view.getSize().x / 10;
+            switch (event.key.code) {
+                case sf::Keyboard::Left: view.move(-step, 0); return true;
+                case sf::Keyboard::Right: view.move(step, 0); return true;
+                case sf::Keyboard::Up: view.move(0, -step); return true;
+                case sf::Keyboard::Down: view.move(0, step); return true;
+                case sf::Keyboard::R:
+                    view = window.getDefaultView();
+                    zoom = 1;
+                    return true;
+                default:
+                    return edit && edit(event.key.code);
+            }
+        }
+        return false;
+    };
+
+    // Main loop - sleep until an event arrives, take every pending event, then draw at most once
+    while (window.isOpen()) {
+        sf::Event event;
+        if (!dirty && window.waitEvent(event)) {
+            dirty = handle(event);
+        }
+        while (window.pollEvent(event)) {
+            dirty = handle(event) || dirty;
+        }
+        if (dirty && window.isOpen()) {
+            window.setView(view);
+            window.clear(sf::Color::Black); // Clear the window with a black color
+            tree.draw(window); // Draw the visible part of the tree
+            window.display(); // Display the contents of the window - waits for the framerate limit
+            dirty = false;
+        }
+    }
+}
+
 int main() {
     // Create a binary tree of Complex numbers
     Tree<Complex> *binaryTree = new Tree<Complex>();
@@ -113,41 +200,40 @@ int main() {
     }
     std::cout << std::endl;
 
-    // Create a window to draw the binary tree
-    sf::RenderWindow window(sf::VideoMode(800, 600), "Complex Binary-Tree Drawing");
-
-    // Main loop to keep the window open and handle events
-    while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            // Close the window if the close event is triggered
-            if (event.type == sf::Event::Closed) {
-                window.close();
-            }
+    // Draw the trees - the windows open one after the other
+    // P - pop the minimum of the heap, A - push a new key; the window is drawn again after each edit
+    double next = 8;
+    showTree(*binaryTree, "Complex Binary-Tree Drawing - P: pop min, A: push", [&](sf::Keyboard::Key key) {
+        if (key == sf::Keyboard::P && binaryTree->size() > 1) {
+            std::cout << "pop_min: " << binaryTree->pop_min() << std::endl;
+            return true;
         }
-
-        window.clear(sf::Color::Black); // Clear the window with a black color
-        binaryTree->draw(window); // Draw the binary tree on the window
-        window.display(); // Display the contents of the window
-    }
-
-    // Create another window to draw the tree of type Tree<int, 3>
-    sf::RenderWindow window2(sf::VideoMode(800, 600), "Tree<int, 3> Drawing");
-
-    // Main loop to keep the second window open and handle events
-    while (window2.isOpen()) {
-        sf::Event event;
-        while (window2.pollEvent(event)) {
-            // Close the window if the close event is triggered
-            if (event.type == sf::Event::Closed) {
-                window2.close();
+        if (key == sf::Keyboard::A) {
+            binaryTree->push(Complex(next, next));
+            next++;
+            return true;
+        }
+        return false;
+    });
+    showTree(*treeK, "Tree<int, 3> Drawing");
+
+    // A large tree - only the nodes inside the view are built and drawn
+    Tree<int, 3> largeTree;
+    largeTree.add_root(0);
+    std::vector<Tree<int, 3>::Node*> level(1, largeTree.get_root());
+    int key = 1;
+    while (key < 100000) {
+        std::vector<Tree<int, 3>::Node*> next;
+        for (auto node : level) {
+            for (int i = 0; i < 3 && key < 100000; ++i) {
+                largeTree.add_sub_node(node, key++);
+                next.push_back(node->children[i]);
             }
         }
-
-        window2.clear(sf::Color::Black); // Clear the window with a black color
-        treeK->draw(window2); // Draw the Tree<int, 3> on the window
-        window2.display(); // Display the contents of the window
+        level.swap(next);
     }
+    showTree(largeTree, "Tree<int, 3> with 100000 nodes - wheel to zoom, drag to pan");
+
     delete binaryTree;
     delete treeK;
     return 0;
@@ -0,0 +1,158 @@
+#ifndef KARY_HEAP_HPP
+#define KARY_HEAP_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+namespace ariel {
+
+    // K-ary heap algorithms over a random access range.
+    // The interface mirrors std::make_heap / std::push_heap / std::pop_heap:
+    // 'comp' is a "less than" function and the element for which no other element
+    // compares greater is kept at the front, so std::greater<T>() builds a min-heap.
+    // For a node at index i its children are at K*i+1 ... K*i+K and its parent at (i-1)/K.
+
+    // Move the element at index 'i' down until none of its children should be above it
+    template <size_t K, typename RandomIt, typename Compare>
+    void sift_down_kary(RandomIt first, size_t size, size_t i, Compare comp) {
+        static_assert(K >= 1, "Heap arity must be at least 1");
+        typename std::iterator_traits<RandomIt>::value_type value = std::move(first[i]);
+
+        while (true) {
+            size_t firstChild = K * i + 1;
+            if (firstChild >= size) break;
+
+            // Find the child that should be the highest of the K children
+            size_t lastChild = firstChild + K < size ? firstChild + K : size;
+            size_t best = firstChild;
+            for (size_t c = firstChild + 1; c < lastChild; ++c) {
+                if (comp(first[best], first[c])) {
+                    best = c;
+                }
+            }
+
+            // Stop when the value is already above its best child
+            if (!comp(value, first[best])) break;
+
+            first[i] = std::move(first[best]);  // Move the child up and continue from its slot
+            i = best;
+        }
+        first[i] = std::move(value);
+    }
+
+    // Move the element at index 'i' up until its parent should be above it
+    template <size_t K, typename RandomIt, typename Compare>
+    void sift_up_kary(RandomIt first, size_t i, Compare comp) {
+        static_assert(K >= 1, "Heap arity must be at least 1");
+        typename std::iterator_traits<RandomIt>::value_type value = std::move(first[i]);
+
+        while (i > 0) {
+            size_t parent = (i - 1) / K;
+            if (!comp(first[parent], value)) break;
+
+            first[i] = std::move(first[parent]);  // Move the parent down and continue from its slot
+            i = parent;
+        }
+        first[i] = std::move(value);
+    }
+
+    // Arrange [first, last) as a K-ary heap - bottom-up (Floyd) construction, O(n)
+    template <size_t K, typename RandomIt, typename Compare>
+    void make_kary_heap(RandomIt first, RandomIt last, Compare comp) {
+        size_t size = static_cast<size_t>(last - first);
+        if (size < 2) return;
+
+        // Sift down every internal node, starting from the last parent up to the root
+        for (size_t i = (size - 2) / K + 1; i-- > 0;) {
+            sift_down_kary<K>(first, size, i, comp);
+        }
+    }
+
+    // Insert the element at last - 1 into the K-ary heap [first, last - 1), O(log_K n)
+    template <size_t K, typename RandomIt, typename Compare>
+    void push_kary_heap(RandomIt first, RandomIt last, Compare comp) {
+        size_t size = static_cast<size_t>(last - first);
+        if (size < 2) return;
+        sift_up_kary<K>(first, size - 1, comp);
+    }
+
+    // Move the top of the K-ary heap [first, last) to last - 1 and restore the heap on [first, last - 1)
+    template <size_t K, typename RandomIt, typename Compare>
+    void pop_kary_heap(RandomIt first, RandomIt last, Compare comp) {
+        size_t size = static_cast<size_t>(last - first);
+        if (size < 2) return;
+
+        using std::swap;
+        swap(first[0], first[size - 1]);
+        sift_down_kary<K>(first, size - 1, 0, comp);
+    }
+
+    // Check whether [first, last) satisfies the K-ary heap property
+    template <size_t K, typename RandomIt, typename Compare>
+    bool is_kary_heap(RandomIt first, RandomIt last, Compare comp) {
+        size_t size = static_cast<size_t>(last - first);
+        for (size_t i = 1; i < size; ++i) {
+            if (comp(first[(i - 1) / K], first[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Bounded heap for top-k selection - keeps the k first keys in 'comp' order offered so far
+    // The worst kept key sits on top of a binary heap, so a new key costs O(log k) and memory stays O(min(k, n))
+    // for n offered keys - the heap grows with the keys it holds, k only caps it
+    template <typename T, typename Compare>
+    class BoundedHeap {
+    public:
+        BoundedHeap(size_t k, Compare comp) : k(k), comp(comp) {}
+
+        // Offer a key - kept if fewer than k keys are held or it comes before the worst kept key
+        void offer(const T& key) {
+            if (heap.size() < k) {
+                heap.push_back(key);
+                std::push_heap(heap.begin(), heap.end(), comp);
+            } else if (k > 0 && comp(key, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), comp);
+                heap.back() = key;
+                std::push_heap(heap.begin(), heap.end(), comp);
+            }
+        }
+
+        // Offer every key kept by another bounded heap
+        void merge(const BoundedHeap& other) {
+            for (const T& key : other.heap) {
+                offer(key);
+            }
+        }
+
+        // Return the kept keys sorted in 'comp' order - the heap is consumed
+        std::vector<T> sorted() {
+            std::sort_heap(heap.begin(), heap.end(), comp);
+            return std::move(heap);
+        }
+
+    private:
+        size_t k;  // Maximum number of kept keys
+        Compare comp;  // Comparison function
+        std::vector<T> heap;  // Kept keys - the worst one on top
+    };
+
+    // Return the k first keys of [first, last) in 'comp' order (sorted), like std::partial_sort_copy
+    // Streams the range once - O(n log k) time and O(min(k, n)) memory, any traversal iterator works
+    template <typename InputIt, typename Compare>
+    std::vector<typename std::decay<decltype(*std::declval<InputIt&>())>::type> top_k(InputIt first, InputIt last, size_t k, Compare comp) {
+        BoundedHeap<typename std::decay<decltype(*std::declval<InputIt&>())>::type, Compare> bounded(k, comp);
+        for (; first != last; ++first) {
+            bounded.offer(*first);
+        }
+        return bounded.sorted();
+    }
+
+}
+
+#endif
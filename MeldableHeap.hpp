@@ -0,0 +1,284 @@
+#ifndef MELDABLE_HEAP_HPP
+#define MELDABLE_HEAP_HPP
+
+#include <vector>
+#include <stack>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <SFML/Graphics.hpp>
+#include "Tree.hpp"
+#include "TreeDrawing.hpp"
+
+namespace ariel {
+
+    // Heap disciplines that support cheap merging (melding) on the binary Node structure
+    enum class MeldDiscipline {
+        Skew,     // Skew heap - merge along the right paths and swap children, O(log n) amortized merge / push / pop
+        Pairing   // Pairing heap - O(1) merge and push, O(log n) amortized pop
+    };
+
+    // Meldable heap built from Tree<T, 2>::Node
+    // Skew:    children[0] / children[1] are the left / right subtrees
+    // Pairing: children[0] is the first child and children[1] the next sibling (left-child right-sibling form)
+    // The parent pointers are not used.
+    // 'Compare' follows std::make_heap - std::greater<T> (default) keeps the minimum on top.
+    template <typename T, MeldDiscipline D = MeldDiscipline::Pairing, typename Compare = std::greater<T>>
+    class MeldableHeap {
+    public:
+        typedef typename Tree<T, 2>::Node Node;
+
+        MeldableHeap(Compare comp = Compare());  // Constructor - empty heap
+        explicit MeldableHeap(Tree<T, 2>& tree, Compare comp = Compare());  // Constructor - push the keys of a tree
+        MeldableHeap(MeldableHeap&& other);  // Move constructor
+        MeldableHeap& operator=(MeldableHeap&& other);  // Move assignment
+        MeldableHeap(const MeldableHeap&) = delete;
+        MeldableHeap& operator=(const MeldableHeap&) = delete;
+        ~MeldableHeap();  // Destructor
+
+        void push(const T& key);  // Insert a key
+        T pop_min();  // Remove and return the top key
+        const T& peek() const;  // Return the top key
+        void meld(MeldableHeap& other);  // Move every key of 'other' into this heap, 'other' becomes empty
+
+        size_t size() const;  // Number of keys
+        bool empty() const;  // True if there are no keys
+        Node* get_root() const;  // Get the root node
+
+        void draw(sf::RenderTarget& window) const;  // Draw the underlying binary node structure
+
+    private:
+        Node* root;  // Root node
+        size_t count;  // Number of keys
+        Compare comp;  // Comparison function
+
+        Node* merge(Node* a, Node* b);  // Helper function to merge two heaps by the discipline
+        Node* mergeSkew(Node* a, Node* b);  // Helper function - top-down skew heap merge
+        Node* link(Node* a, Node* b);  // Helper function - pairing heap link of two roots
+        Node* combineSiblings(Node* first);  // Helper function - pairing heap two-pass combine
+        void clear();  // Helper function to delete every node
+
+        // View of the nodes for the shared drawing functions (TreeDrawing.hpp)
+        struct NodeView {
+            typedef Node* Handle;
+            static const size_t arity = 2;
+            Node* top;
+
+            explicit NodeView(Node* top) : top(top) {}
+            Handle root() const { return top; }
+            bool valid(Handle node) const { return node != nullptr; }
+            Handle child(Handle node, size_t i) const { return node->children[i]; }
+            const T& key(Handle node) const { return node->key; }
+        };
+        mutable TreeRenderer<NodeView> renderer;  // Vertex arrays and labels kept between frames
+    };
+
+
+    // ********** Implementations **********
+
+
+    // Constructor - empty heap
+    template <typename T, MeldDiscipline D, typename Compare>
+    MeldableHeap<T, D, Compare>::MeldableHeap(Compare comp) : root(nullptr), count(0), comp(comp) {}
+
+    // Constructor - push every key of the tree
+    template <typename T, MeldDiscipline D, typename Compare>
+    MeldableHeap<T, D, Compare>::MeldableHeap(Tree<T, 2>& tree, Compare comp) : root(nullptr), count(0), comp(comp) {
+        for (auto it = tree.begin_bfs(); it != tree.end_bfs(); ++it) {
+            push(*it);
+        }
+    }
+
+    // Move constructor - take the nodes of the other heap
+    template <typename T, MeldDiscipline D, typename Compare>
+    MeldableHeap<T, D, Compare>::MeldableHeap(MeldableHeap&& other) : root(other.root), count(other.count), comp(other.comp) {
+        other.root = nullptr;
+        other.count = 0;
+    }
+
+    // Move assignment - release the own nodes and take the nodes of the other heap
+    template <typename T, MeldDiscipline D, typename Compare>
+    MeldableHeap<T, D, Compare>& MeldableHeap<T, D, Compare>::operator=(MeldableHeap&& other) {
+        if (this != &other) {
+            clear();
+            std::swap(root, other.root);
+            std::swap(count, other.count);
+            comp = other.comp;
+            renderer.invalidate();
+            other.renderer.invalidate();
+        }
+        return *this;
+    }
+
+    // Destructor
+    template <typename T, MeldDiscipline D, typename Compare>
+    MeldableHeap<T, D, Compare>::~MeldableHeap() {
+        clear();
+    }
+
+    // Insert a key - merge the heap with a single node heap
+    template <typename T, MeldDiscipline D, typename Compare>
+    void MeldableHeap<T, D, Compare>::push(const T& key) {
+        root = merge(root, new Node(key));
+        count++;
+        renderer.invalidate();
+    }
+
+    // Remove and return the top key
+    // Skew: merge the two subtrees of the root, Pairing: combine the children list of the root
+    template <typename T, MeldDiscipline D, typename Compare>
+    T MeldableHeap<T, D, Compare>::pop_min() {
+        if (!root) {
+            throw std::out_of_range("Heap is empty");
+        }
+        Node* old = root;
+        T top = std::move(old->key);
+        if (D == MeldDiscipline::Skew) {
+            root = mergeSkew(old->children[0], old->children[1]);
+        } else {
+            root = combineSiblings(old->children[0]);
+        }
+        delete old;
+        count--;
+        renderer.invalidate();
+        return top;
+    }
+
+    // Return the top key
+    template <typename T, MeldDiscipline D, typename Compare>
+    const T& MeldableHeap<T, D, Compare>::peek() const {
+        if (!root) {
+            throw std::out_of_range("Heap is empty");
+        }
+        return root->key;
+    }
+
+    // Move every node of the other heap into this heap - no key is copied
+    template <typename T, MeldDiscipline D, typename Compare>
+    void MeldableHeap<T, D, Compare>::meld(MeldableHeap& other) {
+        if (this == &other) return;
+        root = merge(root, other.root);
+        count += other.count;
+        other.root = nullptr;
+        other.count = 0;
+        renderer.invalidate();
+        other.renderer.invalidate();
+    }
+
+    // Get the number of keys
+    template <typename T, MeldDiscipline D, typename Compare>
+    size_t MeldableHeap<T, D, Compare>::size() const {
+        return count;
+    }
+
+    // Check if the heap is empty
+    template <typename T, MeldDiscipline D, typename Compare>
+    bool MeldableHeap<T, D, Compare>::empty() const {
+        return count == 0;
+    }
+
+    // Get the root node
+    template <typename T, MeldDiscipline D, typename Compare>
+    typename MeldableHeap<T, D, Compare>::Node* MeldableHeap<T, D, Compare>::get_root() const {
+        return root;
+    }
+
+    // Function to draw the heap in the specified SFML window - same layout as Tree::draw
+    template <typename T, MeldDiscipline D, typename Compare>
+    void MeldableHeap<T, D, Compare>::draw(sf::RenderTarget& window) const {
+        renderer.draw(window, NodeView(root));
+    }
+
+    // Merge two heaps according to the discipline
+    template <typename T, MeldDiscipline D, typename Compare>
+    typename MeldableHeap<T, D, Compare>::Node* MeldableHeap<T, D, Compare>::merge(Node* a, Node* b) {
+        if (D == MeldDiscipline::Skew) {
+            return mergeSkew(a, b);
+        }
+        if (!a) return b;
+        if (!b) return a;
+        return link(a, b);
+    }
+
+    // Top-down skew heap merge, iterative so long right paths cannot overflow the stack
+    // Along the merge path the higher root is taken, its right subtree continues the merge
+    // and the result becomes its left child (the old left child moves to the right)
+    template <typename T, MeldDiscipline D, typename Compare>
+    typename MeldableHeap<T, D, Compare>::Node* MeldableHeap<T, D, Compare>::mergeSkew(Node* a, Node* b) {
+        Node* result = nullptr;
+        Node** slot = &result;
+        while (a && b) {
+            if (comp(a->key, b->key)) {
+                std::swap(a, b);  // 'a' is the root that stays on top
+            }
+            *slot = a;
+            Node* rest = a->children[1];
+            a->children[1] = a->children[0];
+            slot = &a->children[0];
+            a = rest;
+        }
+        *slot = a ? a : b;
+        return result;
+    }
+
+    // Link two pairing heap roots - the lower root becomes the first child of the higher one
+    template <typename T, MeldDiscipline D, typename Compare>
+    typename MeldableHeap<T, D, Compare>::Node* MeldableHeap<T, D, Compare>::link(Node* a, Node* b) {
+        if (comp(a->key, b->key)) {
+            std::swap(a, b);
+        }
+        b->children[1] = a->children[0];
+        a->children[0] = b;
+        return a;
+    }
+
+    // Pairing heap two-pass combine of a sibling list
+    // First pass: link the siblings in pairs from left to right, second pass: link the pairs from right to left
+    template <typename T, MeldDiscipline D, typename Compare>
+    typename MeldableHeap<T, D, Compare>::Node* MeldableHeap<T, D, Compare>::combineSiblings(Node* first) {
+        std::vector<Node*> pairs;
+        while (first) {
+            Node* a = first;
+            Node* b = a->children[1];
+            if (!b) {
+                a->children[1] = nullptr;
+                pairs.push_back(a);
+                break;
+            }
+            first = b->children[1];
+            a->children[1] = nullptr;
+            b->children[1] = nullptr;
+            pairs.push_back(link(a, b));
+        }
+
+        Node* result = nullptr;
+        for (size_t i = pairs.size(); i-- > 0;) {
+            result = result ? link(pairs[i], result) : pairs[i];
+        }
+        return result;
+    }
+
+    // Delete every node with an explicit stack
+    template <typename T, MeldDiscipline D, typename Compare>
+    void MeldableHeap<T, D, Compare>::clear() {
+        std::stack<Node*> nodeStack;
+        if (root) {
+            nodeStack.push(root);
+        }
+        while (!nodeStack.empty()) {
+            Node* current = nodeStack.top();
+            nodeStack.pop();
+            for (Node* child : current->children) {
+                if (child) {
+                    nodeStack.push(child);
+                }
+            }
+            delete current;
+        }
+        root = nullptr;
+        count = 0;
+    }
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace ariel {
+
+    // Number of worker threads to use - 'requested' if not 0, otherwise the number of hardware threads
+    inline unsigned worker_count(unsigned requested = 0) {
+        if (requested > 0) return requested;
+        unsigned hardware = std::thread::hardware_concurrency();
+        return hardware > 0 ? hardware : 1;
+    }
+
+    // Joins every started thread when it goes out of scope - also when the calling thread's own work throws,
+    // so no joinable std::thread is ever destroyed (that would call std::terminate)
+    class ThreadJoiner {
+    public:
+        explicit ThreadJoiner(std::vector<std::thread>& threads) : threads(threads) {}
+        ~ThreadJoiner() {
+            for (std::thread& thread : threads) {
+                if (thread.joinable()) thread.join();
+            }
+        }
+        ThreadJoiner(const ThreadJoiner&) = delete;
+        ThreadJoiner& operator=(const ThreadJoiner&) = delete;
+
+    private:
+        std::vector<std::thread>& threads;  // Threads to join
+    };
+
+    // Split [begin, end) into one contiguous chunk per thread and call function(chunkBegin, chunkEnd) on each
+    // The calling thread runs the first chunk, the call returns when every chunk is done
+    // An exception of a chunk is rethrown after every thread has been joined - the first chunk's if several threw
+    template <typename Function>
+    void parallel_for(size_t begin, size_t end, unsigned threads, Function function) {
+        if (end <= begin) return;
+        size_t total = end - begin;
+        size_t chunks = threads < total ? threads : total;
+        if (chunks <= 1) {
+            function(begin, end);
+            return;
+        }
+
+        std::vector<std::exception_ptr> errors(chunks);  // Exception of every worker chunk, null if it finished
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        {
+            ThreadJoiner joiner(workers);
+            for (size_t chunk = 1; chunk < chunks; ++chunk) {
+                size_t chunkBegin = begin + total * chunk / chunks;
+                size_t chunkEnd = begin + total * (chunk + 1) / chunks;
+                workers.push_back(std::thread([function, chunk, chunkBegin, chunkEnd, &errors]() mutable {
+                    try {
+                        function(chunkBegin, chunkEnd);
+                    } catch (...) {
+                        errors[chunk] = std::current_exception();
+                    }
+                }));
+            }
+            function(begin, begin + total / chunks);
+        }
+
+        for (const std::exception_ptr& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+}
+
+#endif
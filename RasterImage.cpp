@@ -0,0 +1,397 @@
+#include "RasterImage.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace ariel {
+
+    namespace {
+
+        // Built-in 5x7 font for the node labels - numbers, complex numbers and a few letters
+        // Each row is 5 bits, the highest bit is the left column
+        struct FontGlyph {
+            char ch;
+            uint8_t rows[7];
+        };
+
+        const FontGlyph Glyphs[] = {
+            {'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+            {'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+            {'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+            {'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+            {'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+            {'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+            {'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+            {'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+            {'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+            {'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+            {'+', {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}},
+            {'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+            {'.', {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}},
+            {',', {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}},
+            {'(', {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}},
+            {')', {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}},
+            {'i', {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E}},
+            {'e', {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E}},
+            {'E', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}},
+            {'n', {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11}},
+            {'a', {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F}},
+            {'f', {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08}},
+            {' ', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}}
+        };
+
+        // Drawn for characters the font does not have
+        const FontGlyph Unknown = {'?', {0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F}};
+
+        const int GlyphWidth = 5;
+        const int GlyphHeight = 7;
+        const int GlyphAdvance = 6;
+
+        // Find the glyph of a character
+        const FontGlyph& glyphOf(char ch) {
+            for (const FontGlyph& glyph : Glyphs) {
+                if (glyph.ch == ch) return glyph;
+            }
+            return Unknown;
+        }
+
+        // Big-endian 32-bit value
+        void writeU32(std::string& out, uint32_t value) {
+            out.push_back(static_cast<char>(value >> 24));
+            out.push_back(static_cast<char>(value >> 16));
+            out.push_back(static_cast<char>(value >> 8));
+            out.push_back(static_cast<char>(value));
+        }
+
+        // CRC-32 of PNG chunks, table computed once
+        uint32_t crc32(const std::string& bytes) {
+            static const std::vector<uint32_t> table = [] {
+                std::vector<uint32_t> t(256);
+                for (uint32_t n = 0; n < 256; ++n) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k) {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    t[n] = c;
+                }
+                return t;
+            }();
+            uint32_t c = 0xFFFFFFFFu;
+            for (unsigned char byte : bytes) {
+                c = table[(c ^ byte) & 0xFF] ^ (c >> 8);
+            }
+            return c ^ 0xFFFFFFFFu;
+        }
+
+        // Write a PNG chunk - length, type, data and the CRC of type and data
+        void writeChunk(std::ostream& out, const char* type, const std::string& body) {
+            std::string chunk(type, 4);
+            chunk += body;
+            std::string length;
+            writeU32(length, static_cast<uint32_t>(body.size()));
+            std::string crc;
+            writeU32(crc, crc32(chunk));
+            out << length << chunk << crc;
+        }
+
+        // Deflate bit writer - bits are packed from the least significant bit of each byte
+        class BitWriter {
+        public:
+            explicit BitWriter(std::string& out) : out(out), buffer(0), count(0) {}
+
+            // Write 'bits' bits of 'value', least significant bit first
+            void bits(uint32_t value, int bits) {
+                buffer |= static_cast<uint64_t>(value) << count;
+                count += bits;
+                while (count >= 8) {
+                    out.push_back(static_cast<char>(buffer & 0xFF));
+                    buffer >>= 8;
+                    count -= 8;
+                }
+            }
+
+            // Write a Huffman code - codes are stored most significant bit first
+            void code(uint32_t value, int bits) {
+                uint32_t reversed = 0;
+                for (int i = 0; i < bits; ++i) {
+                    reversed = (reversed << 1) | ((value >> i) & 1);
+                }
+                this->bits(reversed, bits);
+            }
+
+            // Write the last partial byte
+            void flush() {
+                if (count > 0) {
+                    out.push_back(static_cast<char>(buffer & 0xFF));
+                }
+                buffer = 0;
+                count = 0;
+            }
+
+        private:
+            std::string& out;
+            uint64_t buffer;
+            int count;
+        };
+
+        // Literal / length symbol with the fixed Huffman codes of deflate
+        void writeSymbol(BitWriter& writer, unsigned symbol) {
+            if (symbol < 144) writer.code(0x30 + symbol, 8);
+            else if (symbol < 256) writer.code(0x190 + symbol - 144, 9);
+            else if (symbol < 280) writer.code(symbol - 256, 7);
+            else writer.code(0xC0 + symbol - 280, 8);
+        }
+
+        // Match of 3 to 258 bytes at distance 4 (the previous pixel)
+        void writeMatch(BitWriter& writer, unsigned length) {
+            static const unsigned base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+            static const int extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+            unsigned code = 28;
+            while (base[code] > length) --code;
+            writeSymbol(writer, 257 + code);
+            writer.bits(length - base[code], extra[code]);
+            writer.code(3, 5);  // distance code 3 is distance 4, no extra bits
+        }
+
+        // zlib stream of one fixed Huffman deflate block
+        // Runs of a repeated pixel become matches at distance 4, which is what a tree drawing mostly is (background)
+        std::string deflate(const std::string& raw) {
+            std::string out;
+            out.push_back(0x78);  // deflate, 32K window
+            out.push_back(0x01);  // no dictionary, fastest
+            BitWriter writer(out);
+            writer.bits(1, 1);  // last block
+            writer.bits(1, 2);  // fixed Huffman codes
+
+            size_t i = 0;
+            size_t n = raw.size();
+            while (i < n) {
+                size_t run = 0;
+                if (i >= 4) {
+                    while (run < 258 && i + run < n && raw[i + run] == raw[i + run - 4]) ++run;
+                }
+                if (run >= 3) {
+                    writeMatch(writer, static_cast<unsigned>(run));
+                    i += run;
+                } else {
+                    writeSymbol(writer, static_cast<unsigned char>(raw[i]));
+                    ++i;
+                }
+            }
+            writeSymbol(writer, 256);  // end of block
+            writer.flush();
+
+            // Adler-32 of the uncompressed data
+            uint32_t a = 1, b = 0;
+            for (size_t j = 0; j < n;) {
+                size_t end = std::min(n, j + 5552);  // largest block without overflow
+                for (; j < end; ++j) {
+                    a += static_cast<unsigned char>(raw[j]);
+                    b += a;
+                }
+                a %= 65521;
+                b %= 65521;
+            }
+            writeU32(out, (b << 16) | a);
+            return out;
+        }
+
+    }
+
+    // Constructor - every pixel is the background color
+    RasterImage::RasterImage(unsigned width, unsigned height, RasterColor background) : w(width), h(height), data(static_cast<size_t>(width) * height * 4) {
+        fill(background, bounds());
+    }
+
+    // Width in pixels
+    unsigned RasterImage::width() const {
+        return w;
+    }
+
+    // Height in pixels
+    unsigned RasterImage::height() const {
+        return h;
+    }
+
+    // RGBA pixels
+    const uint8_t* RasterImage::pixels() const {
+        return data.data();
+    }
+
+    // Color of one pixel
+    RasterColor RasterImage::pixel(unsigned x, unsigned y) const {
+        if (x >= w || y >= h) {
+            throw std::out_of_range("Pixel out of range");
+        }
+        const uint8_t* p = &data[(static_cast<size_t>(y) * w + x) * 4];
+        return RasterColor{p[0], p[1], p[2], p[3]};
+    }
+
+    // The whole image
+    PixelRect RasterImage::bounds() const {
+        return PixelRect{0, 0, static_cast<int>(w), static_cast<int>(h)};
+    }
+
+    // Set one pixel
+    void RasterImage::put(int x, int y, RasterColor color) {
+        uint8_t* p = &data[(static_cast<size_t>(y) * w + x) * 4];
+        p[0] = color.r;
+        p[1] = color.g;
+        p[2] = color.b;
+        p[3] = color.a;
+    }
+
+    // Fill a rectangle
+    void RasterImage::fill(RasterColor color, const PixelRect& clip) {
+        for (int y = std::max(clip.top, 0); y < std::min(clip.bottom, static_cast<int>(h)); ++y) {
+            for (int x = std::max(clip.left, 0); x < std::min(clip.right, static_cast<int>(w)); ++x) {
+                put(x, y, color);
+            }
+        }
+    }
+
+    // Filled circle - every pixel whose center is inside, and at least the pixel of the center
+    void RasterImage::fill_circle(float cx, float cy, float radius, RasterColor color, const PixelRect& clip) {
+        int left = std::max({clip.left, 0, static_cast<int>(std::floor(cx - radius))});
+        int right = std::min({clip.right, static_cast<int>(w), static_cast<int>(std::ceil(cx + radius)) + 1});
+        int top = std::max({clip.top, 0, static_cast<int>(std::floor(cy - radius))});
+        int bottom = std::min({clip.bottom, static_cast<int>(h), static_cast<int>(std::ceil(cy + radius)) + 1});
+        float r2 = std::max(radius * radius, 0.5f);
+        for (int y = top; y < bottom; ++y) {
+            float dy = y + 0.5f - cy;
+            for (int x = left; x < right; ++x) {
+                float dx = x + 0.5f - cx;
+                if (dx * dx + dy * dy <= r2) {
+                    put(x, y, color);
+                }
+            }
+        }
+    }
+
+    // One pixel wide line - the segment is first clipped to the clip rectangle (Liang-Barsky), then stepped along its major axis
+    void RasterImage::draw_line(float x1, float y1, float x2, float y2, RasterColor color, const PixelRect& clip) {
+        float left = static_cast<float>(std::max(clip.left, 0));
+        float right = static_cast<float>(std::min(clip.right, static_cast<int>(w)));
+        float top = static_cast<float>(std::max(clip.top, 0));
+        float bottom = static_cast<float>(std::min(clip.bottom, static_cast<int>(h)));
+        if (left >= right || top >= bottom) return;
+
+        float dx = x2 - x1;
+        float dy = y2 - y1;
+        float t0 = 0, t1 = 1;
+        const float p[4] = {-dx, dx, -dy, dy};
+        const float q[4] = {x1 - left, right - x1, y1 - top, bottom - y1};
+        for (int i = 0; i < 4; ++i) {
+            if (p[i] == 0) {
+                if (q[i] < 0) return;  // parallel and outside
+            } else {
+                float t = q[i] / p[i];
+                if (p[i] < 0) t0 = std::max(t0, t);
+                else t1 = std::min(t1, t);
+            }
+        }
+        if (t0 > t1) return;
+
+        float sx = x1 + t0 * dx, sy = y1 + t0 * dy;
+        float ex = x1 + t1 * dx, ey = y1 + t1 * dy;
+        int steps = static_cast<int>(std::ceil(std::max(std::abs(ex - sx), std::abs(ey - sy))));
+        float stepX = steps > 0 ? (ex - sx) / steps : 0;
+        float stepY = steps > 0 ? (ey - sy) / steps : 0;
+        for (int i = 0; i <= steps; ++i) {
+            int x = static_cast<int>(std::floor(sx + stepX * i));
+            int y = static_cast<int>(std::floor(sy + stepY * i));
+            if (x >= left && x < right && y >= top && y < bottom) {
+                put(x, y, color);
+            }
+        }
+    }
+
+    // Text in the built-in font - each font pixel is a scale x scale block
+    void RasterImage::draw_text(const std::string& text, float x, float y, int scale, RasterColor color, const PixelRect& clip) {
+        PixelRect area = {std::max(clip.left, 0), std::max(clip.top, 0), std::min(clip.right, static_cast<int>(w)), std::min(clip.bottom, static_cast<int>(h))};
+        int originX = static_cast<int>(std::floor(x));
+        int originY = static_cast<int>(std::floor(y));
+        for (size_t c = 0; c < text.size(); ++c) {
+            const FontGlyph& glyph = glyphOf(text[c]);
+            int glyphX = originX + static_cast<int>(c) * GlyphAdvance * scale;
+            if (glyphX >= area.right) break;
+            if (glyphX + GlyphWidth * scale <= area.left) continue;
+            for (int row = 0; row < GlyphHeight; ++row) {
+                for (int column = 0; column < GlyphWidth; ++column) {
+                    if (!(glyph.rows[row] & (0x10 >> column))) continue;
+                    for (int py = originY + row * scale; py < originY + (row + 1) * scale; ++py) {
+                        if (py < area.top || py >= area.bottom) continue;
+                        for (int px = glyphX + column * scale; px < glyphX + (column + 1) * scale; ++px) {
+                            if (px >= area.left && px < area.right) put(px, py, color);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Width of a text in the built-in font
+    int RasterImage::text_width(const std::string& text, int scale) {
+        return text.empty() ? 0 : (static_cast<int>(text.size()) * GlyphAdvance - 1) * scale;
+    }
+
+    // Binary PPM - header, then RGB rows
+    void RasterImage::write_ppm(std::ostream& out) const {
+        out << "P6\n" << w << " " << h << "\n255\n";
+        std::string row(static_cast<size_t>(w) * 3, '\0');
+        for (unsigned y = 0; y < h; ++y) {
+            const uint8_t* p = &data[static_cast<size_t>(y) * w * 4];
+            for (size_t x = 0; x < w; ++x) {
+                row[x * 3] = static_cast<char>(p[x * 4]);
+                row[x * 3 + 1] = static_cast<char>(p[x * 4 + 1]);
+                row[x * 3 + 2] = static_cast<char>(p[x * 4 + 2]);
+            }
+            out.write(row.data(), static_cast<std::streamsize>(row.size()));
+        }
+    }
+
+    // PNG - signature, IHDR, one IDAT with the zlib stream of the rows (filter type 0), IEND
+    void RasterImage::write_png(std::ostream& out) const {
+        static const char signature[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1A', '\n'};
+        out.write(signature, 8);
+
+        std::string header;
+        writeU32(header, w);
+        writeU32(header, h);
+        header += std::string("\x08\x06\x00\x00\x00", 5);  // 8 bits, RGBA, deflate, adaptive filtering, no interlace
+        writeChunk(out, "IHDR", header);
+
+        std::string raw;
+        raw.reserve((static_cast<size_t>(w) * 4 + 1) * h);
+        for (unsigned y = 0; y < h; ++y) {
+            raw.push_back('\0');
+            raw.append(reinterpret_cast<const char*>(&data[static_cast<size_t>(y) * w * 4]), static_cast<size_t>(w) * 4);
+        }
+        writeChunk(out, "IDAT", deflate(raw));
+        writeChunk(out, "IEND", std::string());
+    }
+
+    // Write the image to a file, the format is chosen by the extension
+    void RasterImage::save(const std::string& path) const {
+        std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : std::string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension != ".png" && extension != ".ppm") {
+            throw std::invalid_argument("Unsupported image format: " + path);
+        }
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        if (extension == ".png") {
+            write_png(file);
+        } else {
+            write_ppm(file);
+        }
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+
+}
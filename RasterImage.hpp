@@ -0,0 +1,54 @@
+#ifndef RASTER_IMAGE_HPP
+#define RASTER_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace ariel {
+
+    // Color of a raster pixel, 8 bits per channel
+    struct RasterColor {
+        uint8_t r, g, b, a;
+    };
+
+    // Pixel rectangle [left, right) x [top, bottom) - the tile a primitive is clipped to
+    struct PixelRect {
+        int left, top, right, bottom;
+    };
+
+    // RGBA image in memory with the primitives of a tree drawing, rasterized on the CPU - no window, no GPU.
+    // Every primitive is clipped to a PixelRect, so threads can draw disjoint tiles of the same image at the same time.
+    class RasterImage {
+    public:
+        RasterImage(unsigned width = 0, unsigned height = 0, RasterColor background = RasterColor{0, 0, 0, 255});  // Constructor - filled with 'background'
+
+        unsigned width() const;  // Width in pixels
+        unsigned height() const;  // Height in pixels
+        const uint8_t* pixels() const;  // RGBA rows from the top, 4 bytes per pixel
+        RasterColor pixel(unsigned x, unsigned y) const;  // Color of one pixel
+        PixelRect bounds() const;  // The whole image
+
+        void fill(RasterColor color, const PixelRect& clip);  // Fill the clip rectangle
+        void fill_circle(float cx, float cy, float radius, RasterColor color, const PixelRect& clip);  // Filled circle, pixel centers inside
+        void draw_line(float x1, float y1, float x2, float y2, RasterColor color, const PixelRect& clip);  // One pixel wide line (DDA)
+        void draw_text(const std::string& text, float x, float y, int scale, RasterColor color, const PixelRect& clip);  // Built-in 5x7 font, top-left at (x, y)
+        static int text_width(const std::string& text, int scale);  // Width of a text in pixels
+
+        void write_ppm(std::ostream& out) const;  // Binary PPM (P6), alpha dropped
+        void write_png(std::ostream& out) const;  // 8-bit RGBA PNG, deflate with run-length matches
+        void save(const std::string& path) const;  // Write a .png or .ppm file (std::invalid_argument for other extensions, std::runtime_error if it cannot be written)
+
+    private:
+        unsigned w;  // Width
+        unsigned h;  // Height
+        std::vector<uint8_t> data;  // RGBA pixels
+
+        void put(int x, int y, RasterColor color);  // Set one pixel, no bounds check
+    };
+
+}
+
+#endif
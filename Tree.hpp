@@ -10,9 +10,23 @@
 #include <functional>
 #include <sstream>
 #include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include "KaryHeap.hpp"
+#include "Parallel.hpp"
+#include "TreeDrawing.hpp"
+#include "TreeRaster.hpp"
+#include "TreeExport.hpp"
 
 namespace ariel {
 
+    const size_t NoLimit = static_cast<size_t>(-1);  // No depth or node limit for Tree::display
+
     // Define the Template of Tree class (Default 2 Children per Node)
     template <typename T, size_t K = 2>
     class Tree {
@@ -22,8 +36,9 @@ namespace ariel {
         struct Node {
             T key;  // Key of the node
             Node* children[K];  // Children of the node
+            Node* parent;  // Parent of the node (nullptr for the root)
 
-            Node(const T& key) : key(key) {  // Constructor for the Node
+            Node(const T& key) : key(key), parent(nullptr) {  // Constructor for the Node
                 for (size_t i = 0; i < K; ++i) {
                     children[i] = nullptr;
                 }
@@ -36,8 +51,15 @@ namespace ariel {
         void add_root(const T& key);  // Add root node
         void add_sub_node(Node* parent, const T& key);  // Add sub node
         Node* get_root() const;  // Get the root node
-        void display() const;  // Display the tree
-        void draw(sf::RenderWindow& window) const; // Draw the tree 
+        size_t size() const;  // Number of nodes in the tree
+        // Print the tree in pre-order, one key per line indented by its depth, down to maxDepth (0 - the root only)
+        // and at most maxNodes lines - iterative, written through a buffer and flushed once at the end
+        void display(std::ostream& out = std::cout, size_t maxDepth = NoLimit, size_t maxNodes = NoLimit) const;
+        void draw(sf::RenderTarget& window) const; // Draw the tree in a window or a render texture
+        const TreeGeometry& build_geometry(sf::Vector2u size, const sf::View& camera) const;  // Build a frame without drawing it - vertex arrays and label placements
+        void save_image(const std::string& path, unsigned width, unsigned height, unsigned threads = 0) const;  // Render the whole tree on the CPU into a .png or .ppm file
+        void write_svg(std::ostream& out) const;  // Write the tree as an SVG document in the viewer's cached layout - may run next to draw() on other threads
+        void write_dot(std::ostream& out) const;  // Write the tree as a Graphviz DOT digraph - nodes numbered in pre-order, O(height) extra memory
 
         // Iterator classes
         class BFSIterator;  // Breadth First Search Iterator
@@ -58,18 +80,122 @@ namespace ariel {
         PostOrderIterator begin_post_order();  // Begin PostOrder Iterator
         PostOrderIterator end_post_order();  // End PostOrder Iterator
 
-        // Method to transform the tree into a min-heap and return an iterator
-        typename Tree<T, K>::BFSIterator myHeap(); // Transform tree into a min-heap and return iterator        
-        
+        // Method to transform the tree into a K-ary min-heap and return an iterator
+        typename Tree<T, K>::BFSIterator myHeap(); // Transform tree into a min-heap and return iterator
+
+        // Heapify with a custom order - comp follows std::make_heap, std::greater<T>() gives a min-heap and std::less<T>() a max-heap
+        template <typename Compare>
+        typename Tree<T, K>::BFSIterator myHeap(Compare comp);
+
+        // Heapify by a derived key - proj(key) is computed once per node and cached during the build, comp compares the projected keys
+        template <typename Compare, typename Projection>
+        typename Tree<T, K>::BFSIterator myHeap(Compare comp, Projection proj);
+
+        // Parallel heapify for very large trees - gathers the keys, builds the heap level by level and rebuilds the nodes
+        // on 'threads' threads (0 = all hardware threads), falls back to myHeap(comp) below ParallelHeapThreshold nodes
+        template <typename Compare = std::greater<T>>
+        typename Tree<T, K>::BFSIterator myHeapParallel(Compare comp = Compare(), unsigned threads = 0);
+        static const size_t ParallelHeapThreshold = 1 << 16;  // Minimum number of nodes for the parallel heapify
+
+        // Top-k selection - the k first keys in 'comp' order (sorted), like std::partial_sort_copy with std::less<T>() giving the k smallest
+        // Streams every node through a bounded heap - O(n log k) time, O(min(k, n)) extra memory, the tree is not changed
+        template <typename Compare = std::less<T>>
+        std::vector<T> top_k(size_t k, Compare comp = Compare()) const;
+        // Parallel top-k - every thread keeps its own bounded heap over a part of the tree and the heaps are merged
+        template <typename Compare = std::less<T>>
+        std::vector<T> top_k_parallel(size_t k, Compare comp = Compare(), unsigned threads = 0) const;
+
+        // Heap-mode operations - valid after myHeap() (or on an empty tree), O(log n) each for K >= 2
+        // They sift keys through the existing nodes and keep the tree a complete K-ary heap
+        // comp must be the same comparison function that was passed to myHeap()
+        // With K == 1 the heap is a chain sorted by comp, so push, pop_min and decrease_key walk it in O(n)
+        template <typename Compare = std::greater<T>>
+        void push(const T& key, Compare comp = Compare());  // Insert a key into the heap - O(log_K n), O(n) for K == 1
+        template <typename Compare = std::greater<T>>
+        T pop_min(Compare comp = Compare());  // Remove and return the top key of the heap - O(log_K n), O(n) for K == 1
+        const T& peek() const;  // Return the top key of the heap - O(1)
+        template <typename Compare = std::greater<T>>
+        void decrease_key(Node* node, const T& key, Compare comp = Compare());  // Move a node's key up in priority - O(log_K n), O(n) for K == 1
+
+        // Key index - an optional hash map from key to node (std::hash<T> and operator==), kept up to date by
+        // add_root, add_sub_node, myHeap and the heap-mode operations while it is enabled
+        struct IndexStats {
+            size_t entries;  // Number of indexed nodes
+            size_t buckets;  // Number of hash buckets
+            float loadFactor;  // Entries per bucket
+            size_t bytes;  // Estimated memory of the index (buckets, entries and key copies)
+        };
+        void enable_index();  // Build the index from the current nodes, O(n)
+        void disable_index();  // Release the index
+        bool has_index() const;  // True while the index is enabled
+        Node* find(const T& key) const;  // A node holding the key or nullptr - O(1) average with the index, BFS otherwise
+        IndexStats index_stats() const;  // Size and memory of the index (all zero when disabled)
+
     private:
         Node* root;  // Root node - field
+        size_t nodeCount;  // Number of nodes in the tree
+        bool heapMode;  // True while the tree is a complete heap (set by myHeap, cleared by add_root/add_sub_node)
+        // Key index behind an abstract interface - the hash map is created only by enable_index(),
+        // so std::hash<T> is required only by the trees that enable the index
+        struct KeyIndex {
+            virtual ~KeyIndex() {}
+            virtual void insert(const T& key, Node* node) = 0;  // Add an entry
+            virtual void erase(const T& key, Node* node) = 0;  // Remove the entry of a node
+            virtual void move(const T& key, Node* from, Node* to) = 0;  // Point the entry of 'from' to 'to'
+            virtual Node* find(const T& key) const = 0;  // A node holding the key or nullptr
+            virtual void clear(size_t capacity) = 0;  // Remove every entry, room for 'capacity' entries
+            virtual IndexStats stats() const = 0;  // Size and memory
+        };
+        struct HashKeyIndex;  // std::unordered_multimap implementation
+        std::unique_ptr<KeyIndex> keyIndex;  // Key index - nullptr while disabled
 
         void clear(Node* node); // Helper functions to clear the tree - delete every node in the Tree.
+        std::vector<T> collectKeys() const;  // Helper function to collect the keys in BFS order
+        void rebuildComplete(const std::vector<T>& elements);  // Helper function to replace the tree with a complete tree in BFS order
+        void splitSubtrees(size_t parts, std::vector<Node*>& top, std::vector<Node*>& subtrees) const;  // Helper function to split the tree into independent subtrees
+        Node* nodeAtIndex(size_t index) const;  // Helper function to find the node at a BFS index of a complete tree
+        void requireHeap() const;  // Helper function to check that heap-mode operations are allowed
+        void rebuildIndex();  // Helper function to index every node again
+        void indexInsert(const T& key, Node* node);  // Helper function to add an index entry
+        void indexErase(const T& key, Node* node);  // Helper function to remove an index entry
+        void indexMove(const T& key, Node* from, Node* to);  // Helper function to follow a key moved to another node
+        template <typename Compare>
+        void siftUp(Node* node, Compare comp);  // Helper function to move a key up towards the root
+        template <typename Compare>
+        void siftDown(Node* node, Compare comp);  // Helper function to move a key down towards the leaves
         
+        Node* childAfter(Node* parent, Node* child) const;  // Helper function to find the next child of a parent after 'child' (nullptr - the first child)
+        template <typename Visit>
+        void walkPreOrder(size_t maxDepth, size_t maxNodes, Visit visit) const;  // Helper function to call visit(node, depth) in pre-order without a stack
+
         // ******GUI -SFML******
-        void displayHelper(Node* node, int indent) const; // Helper functions to display the tree
-        void drawNode(sf::RenderWindow& window, Node* node, sf::Vector2f position, float angle, float distance, int depth) const; // Helper function to draw the Nodes Tree
-        void drawArrow(sf::RenderWindow& window, sf::Vector2f start, sf::Vector2f end) const;  // Helper function to draw the arrow
+        // View of the pointer based nodes for the shared drawing functions (TreeDrawing.hpp)
+        struct NodeView {
+            typedef Node* Handle;
+            static const size_t arity = K;
+            Node* top;
+
+            explicit NodeView(Node* top) : top(top) {}
+            Handle root() const { return top; }
+            bool valid(Handle node) const { return node != nullptr; }
+            Handle child(Handle node, size_t i) const { return node->children[i]; }
+            const T& key(Handle node) const { return node->key; }
+        };
+        mutable TreeRenderer<NodeView> renderer;  // Vertex arrays and labels kept between frames
+    };
+
+    // Define the key index - a hash multimap from key to node, instantiated only by enable_index()
+    template <typename T, size_t K>
+    struct Tree<T, K>::HashKeyIndex : public Tree<T, K>::KeyIndex {
+        typedef std::unordered_multimap<T, Node*> Map;
+        Map entries;  // Key and node of every indexed node
+
+        void insert(const T& key, Node* node) override;
+        void erase(const T& key, Node* node) override;
+        void move(const T& key, Node* from, Node* to) override;
+        Node* find(const T& key) const override;
+        void clear(size_t capacity) override;
+        IndexStats stats() const override;
     };
 
     // Define the BFSIterator class
@@ -162,7 +288,7 @@ namespace ariel {
 
     //Constructor template
     template <typename T, size_t K>
-    Tree<T, K>::Tree() : root(nullptr) {}
+    Tree<T, K>::Tree() : root(nullptr), nodeCount(0), heapMode(false) {}
 
     //Destructor template
     template <typename T, size_t K>
@@ -175,8 +301,15 @@ namespace ariel {
     void Tree<T, K>::add_root(const T& key) {
         if (!root) {
             root = new Node(key);
+            nodeCount = 1;
+            heapMode = true;  // a single node is a heap
+            indexInsert(key, root);
+            renderer.invalidate();
         } else {
+            indexErase(root->key, root);
             root->key = key;
+            heapMode = nodeCount == 1;  // replacing the root key of a larger tree may break the heap
+            indexInsert(key, root);
         }
     }
 
@@ -188,6 +321,11 @@ namespace ariel {
         for (size_t i = 0; i < K; ++i) {
             if (!parent->children[i]) { // Add the sub node to the first empty slot
                 parent->children[i] = new Node(key);
+                parent->children[i]->parent = parent;
+                nodeCount++;
+                indexInsert(key, parent->children[i]);
+                renderer.invalidate();
+                heapMode = false;  // the tree shape is no longer managed by the heap operations
                 return;
             }
         }
@@ -200,6 +338,12 @@ namespace ariel {
         return root;
     }
 
+    // Get the number of nodes in the tree
+    template <typename T, size_t K>
+    size_t Tree<T, K>::size() const {
+        return nodeCount;
+    }
+
     // Clear the tree - free memory
     template <typename T, size_t K>
     void Tree<T, K>::clear(Node* node) {
@@ -210,162 +354,122 @@ namespace ariel {
         delete node;
     }
 
-    // Display the tree
+    // Display the tree - one key per line, indented by its depth
     template <typename T, size_t K>
-    void Tree<T, K>::display() const {
-        displayHelper(root, 0);
+    void Tree<T, K>::display(std::ostream& out, size_t maxDepth, size_t maxNodes) const {
+        {
+            BufferedWriter writer(out);
+            KeyFormatter format(out);
+            walkPreOrder(maxDepth, maxNodes, [&](Node* node, size_t depth) {
+                for (size_t i = 0; i < depth; ++i) writer << "  ";
+                writer << format(node->key) << '\n';
+            });
+        }
+        out.flush();
     }
 
+    // Visit the nodes in pre-order, down to maxDepth and at most maxNodes of them
+    /*
+        Walk the tree with the parent pointers - no recursion and no stack, so deep trees cannot overflow:
+        go down to the first child, and from a leaf (or at maxDepth) climb until a parent has a child after the current node
+    */
     template <typename T, size_t K>
-    void Tree<T, K>::displayHelper(Node* node, int indent) const {
-        // Base case: if the node is null, return
-        if (!node) return;
-        
-        // Print indentation spaces for visual structure
-        for (int i = 0; i < indent; ++i) std::cout << "  ";
-        
-        // Print the node's key
-        std::cout << node->key << std::endl;
-        
-        // Recursively call displayHelper for each child of the node
-        for (size_t i = 0; i < K; ++i) {
-            displayHelper(node->children[i], indent + 1);
+    template <typename Visit>
+    void Tree<T, K>::walkPreOrder(size_t maxDepth, size_t maxNodes, Visit visit) const {
+        Node* node = root;
+        size_t depth = 0;
+        for (size_t visited = 0; node && visited < maxNodes; ++visited) {
+            visit(node, depth);
+
+            Node* next = depth < maxDepth ? childAfter(node, nullptr) : nullptr;
+            if (next) {
+                depth++;
+            } else {
+                for (; node != root; node = node->parent, depth--) {
+                    next = childAfter(node->parent, node);
+                    if (next) break;
+                }
+            }
+            node = next;
         }
     }
 
-    // Function to draw the tree in the specified SFML window
+    // Next child of the parent after 'child' in slot order, or its first child if 'child' is nullptr
     template <typename T, size_t K>
-    void Tree<T, K>::draw(sf::RenderWindow &window) const
-    {
-        try {
-            // Check if the tree has a root node
-            if (root) {
-                // Calculate the initial distance from the root to the first level of children
-                float initialDistance = window.getSize().y / 3;
-
-                // Start drawing the tree from the root node
-                // The root node is positioned in the middle at the top of the window (x: window's width / 2, y: 50)
-                // Angle of 90 degrees for vertical alignment
-                // Initial distance for the first level of children
-                drawNode(window, root, sf::Vector2f(window.getSize().x / 2, 50), 90, initialDistance, 0);
-            }
-        } 
-        catch (const std::exception& e) {
-            // Catch and print any exceptions that occur during drawing
-            std::cerr << e.what() << std::endl;
+    typename Tree<T, K>::Node* Tree<T, K>::childAfter(Node* parent, Node* child) const {
+        size_t i = 0;
+        if (child) {
+            while (parent->children[i] != child) ++i;
+            ++i;
         }
+        for (; i < K; ++i) {
+            if (parent->children[i]) return parent->children[i];
+        }
+        return nullptr;
     }
 
-
-    // Function to draw a node and its children in a GUI window using SFML
+    // Function to draw the tree in the specified SFML window
     template <typename T, size_t K>
-    void Tree<T, K>::drawNode(sf::RenderWindow& window, Node* node, sf::Vector2f position, float angle, float distance, int depth) const
+    void Tree<T, K>::draw(sf::RenderTarget &window) const
     {
-        // Base case: if the node is null, return
-        if (!node) return;
-
-        // Create a circle shape to represent the node
-        sf::CircleShape circle(20);
-        circle.setFillColor(sf::Color::Blue);
-        circle.setPosition(position.x - circle.getRadius(), position.y - circle.getRadius());
-        window.draw(circle);
-        
-        // Load the font for text rendering
-        sf::Font font;
-        if (!font.loadFromFile("arial.ttf")) {
-            std::cerr << "Error loading font\n";
-        }
-        
-        // Create text to display the node's key
-        sf::Text text;
-        text.setFont(font);
-
-        // Use std::ostringstream to convert the node's key to a string
-        std::ostringstream oss;
-        oss << node->key;
-        text.setString(oss.str());
-
-        // Set the text properties
-        text.setCharacterSize(20);
-        text.setFillColor(sf::Color::White);
-        text.setPosition(position.x - circle.getRadius() / 2, position.y - circle.getRadius() / 2);
-        window.draw(text);
-
-        // Calculate new distance for the next level of child nodes
-        float new_distance = distance / 1.5f;  // Reduce the distance for the next level by a factor of 1.5
-
-        // Calculate the angle increment to evenly distribute child nodes around the parent node
-        // 45 degrees divided by (K - 1) ensures that the children are evenly spread out
-        float angleIncrement = 45.0f / (K - 1);  
-
-        // Recursively draw child nodes and arrows
-        for (size_t i = 0; i < K; ++i) {
-            if (node->children[i]) {
-                // Calculate the angle for the current child node
-                // Adjusts the angle for each child node to be evenly spaced
-                float childAngle = angle - (i - (K / 2.0f)) * angleIncrement;
-
-                // Convert the angle from degrees to radians for trigonometric functions
-                float rad = childAngle * 3.14159265359 / 180.0f;
-
-                // Calculate the new position for the child node using polar coordinates
-                sf::Vector2f new_position = position + sf::Vector2f(cos(rad) * distance, sin(rad) * distance);
-                
-                try{
-                    // Draw the child node at the calculated position
-                    drawNode(window, node->children[i], new_position, childAngle, new_distance, depth + 1);
-                } catch (const std::exception& e) {
-                    std::cerr << "Error drawing node: " << e.what() << std::endl;
-                }
+        renderer.draw(window, NodeView(root));
+    }
 
-                try{
-                    // Draw an arrow from the current node to the child node
-                    drawArrow(window, position, new_position);
-                } catch (const std::exception& e) {
-                    std::cerr << "Error drawing arrow: " << e.what() << std::endl;
-                }
-            
-            
-            }
-        }
+    // Build the frame draw() would show on a target of 'size' pixels with the view 'camera', without a window
+    // The geometry is kept for the next frame, so it is valid until the tree is drawn or built again - by any thread,
+    // read it while no other thread draws the tree
+    template <typename T, size_t K>
+    const TreeGeometry& Tree<T, K>::build_geometry(sf::Vector2u size, const sf::View& camera) const
+    {
+        renderer.build(size, camera, NodeView(root));
+        return renderer.geometry();
     }
 
-    // Function to draw an arrow between two points in a GUI window using SFML
+    // Render the tree without a window - the viewer's layout scaled to fit the image, rasterized on 'threads' threads
+    // (0 - every hardware thread), then written as PNG or PPM by the extension of the path
     template <typename T, size_t K>
-    void Tree<T, K>::drawArrow(sf::RenderWindow &window, sf::Vector2f start, sf::Vector2f end) const
+    void Tree<T, K>::save_image(const std::string& path, unsigned width, unsigned height, unsigned threads) const
     {
-        // Draw the main line of the arrow
-        sf::Vertex line[] = {
-            sf::Vertex(start),
-            sf::Vertex(end)
-        };
-        window.draw(line, 2, sf::Lines);
+        RasterImage image(width, height);
+        rasterizeTree(NodeView(root), image, threads);
+        image.save(path);
+    }
 
-        // Calculate the direction vector from start to end
-        sf::Vector2f direction = end - start;
-        
-        // Calculate the length of the direction vector
-        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
-        
-        // Normalize the direction vector to unit length
-        direction /= length;
+    // Write the tree as SVG - the renderer's cached layout (computed here only if the tree changed since it was last
+    // drawn or exported) streamed through a fixed size buffer, no document is built in memory
+    // Safe to call from several threads and next to draw() on the same const tree: the renderer's mutex is held for
+    // the whole write, so the others wait for it (like any const function, not while the tree itself is changed)
+    template <typename T, size_t K>
+    void Tree<T, K>::write_svg(std::ostream& out) const
+    {
+        NodeView view(root);
+        renderer.read_layout(view, [&](const TreeLayout<Node*>& layout) { writeSvg(layout, view, out); });
+    }
 
-        // Set the size of the arrowhead
-        float arrowSize = 10.0f;
-        
-        // Calculate the points for the arrowhead
-        // The arrowhead is created by taking the direction vector and adjusting it perpendicularly
-        sf::Vector2f arrowPoint1 = end - direction * arrowSize + sf::Vector2f(-direction.y, direction.x) * arrowSize * 0.5f;
-        sf::Vector2f arrowPoint2 = end - direction * arrowSize + sf::Vector2f(direction.y, -direction.x) * arrowSize * 0.5f;
-
-        // Draw the arrowhead
-        sf::Vertex arrowhead[] = {
-            sf::Vertex(end),
-            sf::Vertex(arrowPoint1),
-            sf::Vertex(end),
-            sf::Vertex(arrowPoint2)
-        };
-        window.draw(arrowhead, 4, sf::Lines);
+    // Write the tree as Graphviz DOT - a pre-order walk along the parent pointers, every node statement followed by the
+    // edge from its parent; nodes are named by their pre-order number (n0 is the root), so the same tree always gives
+    // the same document. Only the fixed size buffer and the numbers of the current node's ancestors (O(height)) are kept.
+    template <typename T, size_t K>
+    void Tree<T, K>::write_dot(std::ostream& out) const
+    {
+        BufferedWriter writer(out);
+        KeyFormatter format;
+        std::vector<size_t> ancestors;  // Pre-order number of the node at each depth on the current path
+        size_t next = 0;
+        writer << "digraph Tree {\n"
+               << "node [shape=circle, style=filled, fillcolor=blue, fontcolor=white];\n";
+        walkPreOrder(NoLimit, NoLimit, [&](Node* node, size_t depth) {
+            size_t id = next++;
+            ancestors.resize(depth + 1);
+            ancestors[depth] = id;
+            writer << 'n' << id << " [label=\"";
+            writer.write_quoted(format(node->key));
+            writer << "\"];\n";
+            if (depth > 0) {
+                writer << 'n' << ancestors[depth - 1] << " -> n" << id << ";\n";
+            }
+        });
+        writer << "}\n";
     }
 
     // Define the start point of BFS - begin in the root of the tree
@@ -429,20 +533,76 @@ namespace ariel {
 
 // Function to insert tree data into a vector, convert it to a min-heap, rebuild the tree as a min-heap, and return a BFS iterator
 /*
-    Step 1: Convert the binary tree to a vector
-    Step 2: Build a min-heap from the collected elements
-    Step 3: Rebuild the tree as a min-heap
+    Step 1: Convert the tree to a vector
+    Step 2: Build a K-ary min-heap from the collected elements
+    Step 3: Rebuild the tree as a complete K-ary min-heap
     Step 4: Return a BFS iterator to the minimum heap
 */
 template <typename T, size_t K>
 typename Tree<T, K>::BFSIterator Tree<T, K>::myHeap()
 {
-    // Ensure the tree is binary (i.e., each node has at most 2 children)
-    if (K != 2) {
-        throw std::invalid_argument("Tree is not binary");
+    // the comparison function std::greater<T>() (check if i <= j, else swap) creates a min-heap
+    return myHeap(std::greater<T>());
+}
+
+// Heapify the tree with a custom comparison function
+template <typename T, size_t K>
+template <typename Compare>
+typename Tree<T, K>::BFSIterator Tree<T, K>::myHeap(Compare comp)
+{
+    // Step 1: Convert the tree to a vector
+    std::vector<T> elements = collectKeys();
+
+    // Step 2: Build a K-ary heap from the collected elements
+    // make_kary_heap rearranges the elements in place (like std::make_heap, which only supports K = 2)
+    // where the children of element i are at K*i+1 ... K*i+K
+    make_kary_heap<K>(elements.begin(), elements.end(), comp);
+
+    // Step 3: Rebuild the tree as a heap
+    rebuildComplete(elements);
+
+    // Step 4: Return a BFS iterator to the heap
+    return this->begin_bfs();
+}
+
+// Heapify the tree by a projected key
+// The projection is computed once per node and stored next to the key, so expensive keys
+// (for example the magnitude of a Complex number) are not recomputed on every comparison
+template <typename T, size_t K>
+template <typename Compare, typename Projection>
+typename Tree<T, K>::BFSIterator Tree<T, K>::myHeap(Compare comp, Projection proj)
+{
+    typedef typename std::decay<decltype(proj(std::declval<const T&>()))>::type ProjectedKey;
+    typedef std::pair<ProjectedKey, T> Entry;
+
+    // Step 1: Convert the tree to a vector of (projected key, key) pairs
+    std::vector<T> elements = collectKeys();
+    std::vector<Entry> entries;
+    entries.reserve(elements.size());
+    for (T& element : elements) {
+        ProjectedKey projected = proj(element);
+        entries.push_back(Entry(std::move(projected), std::move(element)));
     }
 
-    // Step 1: Convert the binary tree to a vector
+    // Step 2: Build a K-ary heap ordered only by the cached projected keys
+    make_kary_heap<K>(entries.begin(), entries.end(), [&comp](const Entry& a, const Entry& b) {
+        return comp(a.first, b.first);
+    });
+
+    // Step 3: Rebuild the tree as a heap
+    for (size_t i = 0; i < entries.size(); ++i) {
+        elements[i] = std::move(entries[i].second);
+    }
+    rebuildComplete(elements);
+
+    // Step 4: Return a BFS iterator to the heap
+    return this->begin_bfs();
+}
+
+// Collect all the node keys into a vector using BFS traversal
+template <typename T, size_t K>
+std::vector<T> Tree<T, K>::collectKeys() const
+{
     std::vector<T> elements;
     std::queue<Node*> nodeQueue;
     
@@ -466,34 +626,577 @@ typename Tree<T, K>::BFSIterator Tree<T, K>::myHeap()
             }
         }
     }
+    return elements;
+}
 
-    // Step 2: Build a min-heap from the collected elements
-    // make_heap does not create new container just reaarange the elements in the elements container
-    // using iterator begin and end, and the comparison function std::greater<T>() (check if i <= j, else swap) to create a min-heap
-    std::make_heap(elements.begin(), elements.end(), std::greater<T>());
+// Replace the tree with a complete K-ary tree holding the elements in BFS order
+// The old nodes are released first
+template <typename T, size_t K>
+void Tree<T, K>::rebuildComplete(const std::vector<T>& elements)
+{
+    clear(root);
+    root = nullptr;
 
-    // Step 3: Rebuild the tree as a min-heap
-    std::queue<Node**> pointerQueue;
+    // Queue of (parent node, address of the child pointer) pairs
+    std::queue<std::pair<Node*, Node**>> pointerQueue;
     
     // Initialize the queue with the address of the root pointer
-    pointerQueue.push(&root);
+    pointerQueue.push(std::make_pair(static_cast<Node*>(nullptr), &root));
     
-    // Iterate through the elements in the min-heap and rebuild the tree
+    // Iterate through the elements in the heap and rebuild the tree
     for (const T& element : elements) {
         // Get the current node pointer
-        Node** currentPointer = pointerQueue.front();
+        std::pair<Node*, Node**> current = pointerQueue.front();
         pointerQueue.pop();
         
         // Create a new node with the current element and assign it to the current pointer
-        *currentPointer = new Node(element);
+        Node* node = new Node(element);
+        node->parent = current.first;
+        *current.second = node;
         
-        // Add the addresses of the children pointers to the queue for further processing
-        pointerQueue.push(&((*currentPointer)->children[0]));
-        pointerQueue.push(&((*currentPointer)->children[1]));
+        // Add the addresses of all K children pointers to the queue for further processing
+        for (size_t i = 0; i < K; ++i) {
+            pointerQueue.push(std::make_pair(node, &node->children[i]));
+        }
+    }
+
+    nodeCount = elements.size();
+    heapMode = true;
+    rebuildIndex();
+    renderer.invalidate();
+}
+
+// Heapify the tree on several threads
+/*
+    Step 1: Split the tree into independent subtrees, collect the keys of each subtree and delete its nodes in parallel
+    Step 2: Build the K-ary heap bottom-up, level by level - the sift-downs of one level touch disjoint subtrees
+    Step 3: Allocate the new nodes and link them to their children in parallel
+    Step 4: Return a BFS iterator to the heap
+*/
+template <typename T, size_t K>
+template <typename Compare>
+typename Tree<T, K>::BFSIterator Tree<T, K>::myHeapParallel(Compare comp, unsigned threads)
+{
+    threads = worker_count(threads);
+    if (threads == 1 || nodeCount < ParallelHeapThreshold) {
+        return myHeap(comp);  // serial fallback - the thread start-up costs more than it saves
+    }
+
+    // Step 1: Collect the keys of every subtree on its own thread
+    std::vector<Node*> top;
+    std::vector<Node*> subtrees;
+    splitSubtrees(threads * 8, top, subtrees);
+
+    std::vector<T> elements;
+    elements.reserve(nodeCount);
+    for (Node* node : top) {  // the few nodes above the split are collected by the calling thread
+        elements.push_back(node->key);
+    }
+
+    std::vector<std::vector<T>> parts(threads);
+    parallel_for(0, threads, threads, [&](size_t firstPart, size_t lastPart) {
+        for (size_t p = firstPart; p < lastPart; ++p) {
+            // Each part owns a contiguous range of the subtrees and walks them with its own DFS stack
+            std::stack<Node*> nodeStack;
+            for (size_t i = subtrees.size() * p / threads; i < subtrees.size() * (p + 1) / threads; ++i) {
+                nodeStack.push(subtrees[i]);
+            }
+            while (!nodeStack.empty()) {
+                Node* current = nodeStack.top();
+                nodeStack.pop();
+                for (size_t c = 0; c < K; ++c) {
+                    if (current->children[c]) {
+                        nodeStack.push(current->children[c]);
+                    }
+                }
+                parts[p].push_back(std::move(current->key));
+                delete current;
+            }
+        }
+    });
+    for (Node* node : top) {
+        delete node;
+    }
+    root = nullptr;
+    for (std::vector<T>& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(elements));
+        std::vector<T>().swap(part);
+    }
+
+    // Step 2: Build the heap level by level, starting from the deepest level that has children
+    size_t size = elements.size();
+    size_t lastParent = (size - 2) / K;
+    std::vector<size_t> levelStarts(1, 0);  // BFS index of the first node of every level
+    while (levelStarts.back() <= lastParent) {
+        levelStarts.push_back(levelStarts.back() * K + 1);
+    }
+    for (size_t level = levelStarts.size() - 1; level-- > 0;) {
+        size_t begin = levelStarts[level];
+        size_t end = std::min(levelStarts[level + 1], lastParent + 1);
+        // Small levels near the root are not worth a thread each
+        unsigned levelThreads = end - begin < 1024 ? 1 : threads;
+        parallel_for(begin, end, levelThreads, [&](size_t chunkBegin, size_t chunkEnd) {
+            for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                sift_down_kary<K>(elements.begin(), size, i, comp);
+            }
+        });
+    }
+
+    // Step 3: Rebuild the tree as a complete K-ary heap - every node links its own children
+    std::vector<Node*> nodes(size);
+    parallel_for(0, size, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            nodes[i] = new Node(std::move(elements[i]));
+        }
+    });
+    parallel_for(0, size, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t c = 0; c < K && K * i + 1 + c < size; ++c) {
+                nodes[i]->children[c] = nodes[K * i + 1 + c];
+                nodes[K * i + 1 + c]->parent = nodes[i];
+            }
+        }
+    });
+    root = nodes[0];
+    heapMode = true;
+    rebuildIndex();
+    renderer.invalidate();
+
+    // Step 4: Return a BFS iterator to the heap
+    return this->begin_bfs();
+}
+
+// Select the k first keys - walk the tree with a DFS stack and offer every key to a bounded heap
+template <typename T, size_t K>
+template <typename Compare>
+std::vector<T> Tree<T, K>::top_k(size_t k, Compare comp) const
+{
+    BoundedHeap<T, Compare> bounded(k, comp);
+    std::stack<Node*> nodeStack;
+    if (root) {
+        nodeStack.push(root);
+    }
+    while (!nodeStack.empty()) {
+        Node* current = nodeStack.top();
+        nodeStack.pop();
+        bounded.offer(current->key);
+        for (size_t i = 0; i < K; ++i) {
+            if (current->children[i]) {
+                nodeStack.push(current->children[i]);
+            }
+        }
+    }
+    return bounded.sorted();
+}
+
+// Select the k first keys on several threads
+// Each thread walks its own subtrees into its own bounded heap, then the per-thread heaps are merged
+template <typename T, size_t K>
+template <typename Compare>
+std::vector<T> Tree<T, K>::top_k_parallel(size_t k, Compare comp, unsigned threads) const
+{
+    threads = worker_count(threads);
+    if (threads == 1 || nodeCount < ParallelHeapThreshold) {
+        return top_k(k, comp);  // serial fallback
+    }
+
+    std::vector<Node*> top;
+    std::vector<Node*> subtrees;
+    splitSubtrees(threads * 8, top, subtrees);
+
+    std::vector<BoundedHeap<T, Compare>> parts(threads, BoundedHeap<T, Compare>(k, comp));
+    parallel_for(0, threads, threads, [&](size_t firstPart, size_t lastPart) {
+        for (size_t p = firstPart; p < lastPart; ++p) {
+            std::stack<Node*> nodeStack;
+            for (size_t i = subtrees.size() * p / threads; i < subtrees.size() * (p + 1) / threads; ++i) {
+                nodeStack.push(subtrees[i]);
+            }
+            while (!nodeStack.empty()) {
+                Node* current = nodeStack.top();
+                nodeStack.pop();
+                parts[p].offer(current->key);
+                for (size_t c = 0; c < K; ++c) {
+                    if (current->children[c]) {
+                        nodeStack.push(current->children[c]);
+                    }
+                }
+            }
+        }
+    });
+
+    // Merge - the nodes above the split and every per-thread heap go into one bounded heap
+    BoundedHeap<T, Compare> bounded(k, comp);
+    for (Node* node : top) {
+        bounded.offer(node->key);
+    }
+    for (const BoundedHeap<T, Compare>& part : parts) {
+        bounded.merge(part);
+    }
+    return bounded.sorted();
+}
+
+// Split the tree into at least 'parts' subtrees (when the tree is large enough)
+// Expands the BFS frontier from the root - the expanded nodes go to 'top', the frontier roots to 'subtrees'
+template <typename T, size_t K>
+void Tree<T, K>::splitSubtrees(size_t parts, std::vector<Node*>& top, std::vector<Node*>& subtrees) const
+{
+    std::queue<Node*> frontier;
+    if (root) {
+        frontier.push(root);
+    }
+    while (!frontier.empty() && frontier.size() < parts) {
+        Node* current = frontier.front();
+        frontier.pop();
+        top.push_back(current);
+        for (size_t i = 0; i < K; ++i) {
+            if (current->children[i]) {
+                frontier.push(current->children[i]);
+            }
+        }
+    }
+    while (!frontier.empty()) {
+        subtrees.push_back(frontier.front());
+        frontier.pop();
+    }
+}
+
+// Find the node at a BFS index of a complete K-ary tree - O(log n), O(index) for the chain of K == 1
+// The path from the root is given by the base-K digits of the index offset inside its level
+template <typename T, size_t K>
+typename Tree<T, K>::Node* Tree<T, K>::nodeAtIndex(size_t index) const
+{
+    Node* node = root;
+    if (K == 1) {  // a chain - follow the single child 'index' times
+        for (size_t i = 0; i < index; ++i) {
+            node = node->children[0];
+        }
+        return node;
+    }
+
+    // Find the size of the level holding the index (K^depth) and the offset inside it
+    size_t levelSize = 1;
+    size_t offset = index;
+    while (offset >= levelSize) {
+        offset -= levelSize;
+        levelSize *= K;
+    }
+
+    // The most significant digit selects the child of the root, the least significant the last step
+    for (size_t step = levelSize / K; step > 0; step /= K) {
+        node = node->children[(offset / step) % K];
+    }
+    return node;
+}
+
+// Heap-mode operations are only valid while the tree is a complete heap
+template <typename T, size_t K>
+void Tree<T, K>::requireHeap() const
+{
+    if (root && !heapMode) {
+        throw std::logic_error("Tree is not a heap, call myHeap() first");
+    }
+}
+
+// Move the key of the node up while it should be above its parent
+// The key is held aside and the parents' keys are shifted down, one move per level
+template <typename T, size_t K>
+template <typename Compare>
+void Tree<T, K>::siftUp(Node* node, Compare comp)
+{
+    Node* start = node;
+    T value = std::move(node->key);
+    while (node->parent && comp(node->parent->key, value)) {
+        indexMove(node->parent->key, node->parent, node);
+        node->key = std::move(node->parent->key);
+        node = node->parent;
+    }
+    indexMove(value, start, node);
+    node->key = std::move(value);
+}
+
+// Move the key of the node down while one of its children should be above it
+template <typename T, size_t K>
+template <typename Compare>
+void Tree<T, K>::siftDown(Node* node, Compare comp)
+{
+    Node* start = node;
+    T value = std::move(node->key);
+    while (true) {
+        // Find the child that should be the highest of the K children
+        Node* best = nullptr;
+        for (size_t i = 0; i < K && node->children[i]; ++i) {
+            if (!best || comp(best->key, node->children[i]->key)) {
+                best = node->children[i];
+            }
+        }
+
+        // Stop when the value is already above its best child
+        if (!best || !comp(value, best->key)) break;
+
+        indexMove(best->key, best, node);
+        node->key = std::move(best->key);
+        node = best;
+    }
+    indexMove(value, start, node);
+    node->key = std::move(value);
+}
+
+// Insert a key into the heap
+// The new node takes the next free slot of the complete tree (BFS index size()) and its key is sifted up
+template <typename T, size_t K>
+template <typename Compare>
+void Tree<T, K>::push(const T& key, Compare comp)
+{
+    requireHeap();
+    if (!root) {
+        add_root(key);
+        return;
+    }
+
+    Node* parent = nodeAtIndex((nodeCount - 1) / K);
+    Node* node = new Node(key);
+    node->parent = parent;
+    parent->children[(nodeCount - 1) % K] = node;
+    nodeCount++;
+    indexInsert(key, node);
+    renderer.invalidate();
+
+    siftUp(node, comp);
+}
+
+// Remove and return the top key of the heap
+// The key of the last node moves to the root, the last node is deleted, and the root key is sifted down
+template <typename T, size_t K>
+template <typename Compare>
+T Tree<T, K>::pop_min(Compare comp)
+{
+    requireHeap();
+    if (!root) {
+        throw std::out_of_range("Heap is empty");
+    }
+
+    indexErase(root->key, root);
+    T top = std::move(root->key);
+    Node* last = nodeAtIndex(nodeCount - 1);
+    renderer.invalidate();
+    if (last == root) {
+        delete root;
+        root = nullptr;
+        nodeCount = 0;
+        return top;
+    }
+
+    indexMove(last->key, last, root);
+    root->key = std::move(last->key);
+    last->parent->children[(nodeCount - 2) % K] = nullptr;  // the last node is the child slot (index - 1) % K of its parent
+    delete last;
+    nodeCount--;
+
+    siftDown(root, comp);
+    return top;
+}
+
+// Return the top key of the heap
+template <typename T, size_t K>
+const T& Tree<T, K>::peek() const
+{
+    requireHeap();
+    if (!root) {
+        throw std::out_of_range("Heap is empty");
+    }
+    return root->key;
+}
+
+// Replace the key of a node with a key of higher (or equal) priority and sift it up
+template <typename T, size_t K>
+template <typename Compare>
+void Tree<T, K>::decrease_key(Node* node, const T& key, Compare comp)
+{
+    requireHeap();
+    if (!node) return;
+    if (comp(key, node->key)) {
+        throw std::invalid_argument("New key has lower priority than the current key");
+    }
+
+    indexErase(node->key, node);
+    node->key = key;
+    indexInsert(key, node);
+    siftUp(node, comp);
+}
+
+// Build the index from the current nodes
+template <typename T, size_t K>
+void Tree<T, K>::enable_index()
+{
+    if (!keyIndex) {
+        keyIndex.reset(new HashKeyIndex());
+    }
+    rebuildIndex();
+}
+
+// Release the index - the tree operations stop maintaining it
+template <typename T, size_t K>
+void Tree<T, K>::disable_index()
+{
+    keyIndex.reset();
+}
+
+// Check if the index is enabled
+template <typename T, size_t K>
+bool Tree<T, K>::has_index() const
+{
+    return keyIndex != nullptr;
+}
+
+// Find a node holding the key - one hash lookup with the index, a BFS walk without it
+// With duplicate keys any of the nodes holding the key may be returned
+template <typename T, size_t K>
+typename Tree<T, K>::Node* Tree<T, K>::find(const T& key) const
+{
+    if (keyIndex) {
+        return keyIndex->find(key);
     }
 
-    // Step 4: Return a BFS iterator to the minimum heap
-    return this->begin_bfs();  // Return BFS iterator to the minimum heap
+    std::queue<Node*> nodeQueue;
+    if (root) {
+        nodeQueue.push(root);
+    }
+    while (!nodeQueue.empty()) {
+        Node* current = nodeQueue.front();
+        nodeQueue.pop();
+        if (current->key == key) {
+            return current;
+        }
+        for (size_t i = 0; i < K; ++i) {
+            if (current->children[i]) {
+                nodeQueue.push(current->children[i]);
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Report the index size
+template <typename T, size_t K>
+typename Tree<T, K>::IndexStats Tree<T, K>::index_stats() const
+{
+    IndexStats stats = {0, 0, 0.0f, 0};
+    if (keyIndex) {
+        stats = keyIndex->stats();
+    }
+    return stats;
+}
+
+// Index every node again - used after the nodes are rebuilt (myHeap)
+template <typename T, size_t K>
+void Tree<T, K>::rebuildIndex()
+{
+    if (!keyIndex) return;
+    keyIndex->clear(nodeCount);
+    std::stack<Node*> nodeStack;
+    if (root) {
+        nodeStack.push(root);
+    }
+    while (!nodeStack.empty()) {
+        Node* current = nodeStack.top();
+        nodeStack.pop();
+        keyIndex->insert(current->key, current);
+        for (size_t i = 0; i < K; ++i) {
+            if (current->children[i]) {
+                nodeStack.push(current->children[i]);
+            }
+        }
+    }
+}
+
+// Add the entry (key, node) to the index
+template <typename T, size_t K>
+void Tree<T, K>::indexInsert(const T& key, Node* node)
+{
+    if (keyIndex) {
+        keyIndex->insert(key, node);
+    }
+}
+
+// Remove the entry (key, node) from the index
+template <typename T, size_t K>
+void Tree<T, K>::indexErase(const T& key, Node* node)
+{
+    if (keyIndex) {
+        keyIndex->erase(key, node);
+    }
+}
+
+// The key of 'from' moved to 'to' - point its entry to the new node
+template <typename T, size_t K>
+void Tree<T, K>::indexMove(const T& key, Node* from, Node* to)
+{
+    if (keyIndex && from != to) {
+        keyIndex->move(key, from, to);
+    }
+}
+
+// Add the entry (key, node)
+template <typename T, size_t K>
+void Tree<T, K>::HashKeyIndex::insert(const T& key, Node* node)
+{
+    entries.insert(std::make_pair(key, node));
+}
+
+// Remove the entry of the node among the entries of the key
+template <typename T, size_t K>
+void Tree<T, K>::HashKeyIndex::erase(const T& key, Node* node)
+{
+    std::pair<typename Map::iterator, typename Map::iterator> range = entries.equal_range(key);
+    for (typename Map::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == node) {
+            entries.erase(it);
+            return;
+        }
+    }
+}
+
+// Point the entry of 'from' among the entries of the key to 'to'
+template <typename T, size_t K>
+void Tree<T, K>::HashKeyIndex::move(const T& key, Node* from, Node* to)
+{
+    std::pair<typename Map::iterator, typename Map::iterator> range = entries.equal_range(key);
+    for (typename Map::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == from) {
+            it->second = to;
+            return;
+        }
+    }
+}
+
+// One hash lookup
+template <typename T, size_t K>
+typename Tree<T, K>::Node* Tree<T, K>::HashKeyIndex::find(const T& key) const
+{
+    typename Map::const_iterator it = entries.find(key);
+    return it == entries.end() ? nullptr : it->second;
+}
+
+// Remove every entry and reserve the buckets for 'capacity' entries
+template <typename T, size_t K>
+void Tree<T, K>::HashKeyIndex::clear(size_t capacity)
+{
+    entries.clear();
+    entries.reserve(capacity);
+}
+
+// Report the size - the memory is estimated from the node layout of std::unordered_multimap
+// (one bucket pointer per bucket, and per entry a next pointer, the cached hash, the key copy and the Node*)
+template <typename T, size_t K>
+typename Tree<T, K>::IndexStats Tree<T, K>::HashKeyIndex::stats() const
+{
+    IndexStats stats;
+    stats.entries = entries.size();
+    stats.buckets = entries.bucket_count();
+    stats.loadFactor = entries.load_factor();
+    stats.bytes = sizeof(HashKeyIndex) + stats.buckets * sizeof(void*) +
+                  stats.entries * (sizeof(void*) + sizeof(size_t) + sizeof(typename Map::value_type));
+    return stats;
 }
 
 
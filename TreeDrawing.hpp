@@ -0,0 +1,753 @@
+#ifndef TREE_DRAWING_HPP
+#define TREE_DRAWING_HPP
+
+#include <iostream>
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <type_traits>
+#include <algorithm>
+#include "TreeLayout.hpp"
+
+namespace ariel {
+
+    // ******GUI -SFML******
+    // Drawing functions shared by every tree representation (pointer based Tree and array based ArrayHeap).
+    // A tree is drawn through a view that provides:
+    //   typedef ... Handle;                            - a node of the tree (Node* or an array index)
+    //   static const size_t arity;                     - maximum number of children per node (K)
+    //   Handle root() const;                           - the root node
+    //   bool valid(Handle node) const;                 - false for a missing node
+    //   Handle child(Handle node, size_t i) const;     - the i-th child of a node
+    //   const Key& key(Handle node) const;             - the key printed in the node
+    // The drawing functions take any sf::RenderTarget - a window or an off-screen sf::RenderTexture.
+
+    // Fonts loaded once per file and shared by every tree, window and frame
+    // The default file is "arial.ttf" in the working directory and can be changed with set_default_path
+    class FontCache {
+    public:
+        static const sf::Font* get(const std::string& path);  // The font of a file, loaded on first use - nullptr if it cannot be loaded
+        static const sf::Font* default_font();  // The font of the default file
+        static void set_default_path(const std::string& path);  // Change the default font file
+        static std::string default_path();  // The default font file
+        static bool is_cached(const std::string& path);  // True once a file was loaded or failed to load - never loads it
+
+    private:
+        struct Storage {
+            std::mutex mutex;  // Guards the fields - trees may be drawn from several threads
+            std::string defaultPath = "arial.ttf";
+            std::map<std::string, std::unique_ptr<sf::Font>> fonts;  // nullptr for files that failed to load
+        };
+        static Storage& storage();  // The single storage, created on first use
+        static const sf::Font* load(Storage& cache, const std::string& path);  // Find or load a font, the mutex is held by the caller
+    };
+
+    // Get the storage of the cache
+    inline FontCache::Storage& FontCache::storage()
+    {
+        static Storage instance;
+        return instance;
+    }
+
+    // Get the font of a file - the file is read and parsed only the first time
+    // A file that cannot be loaded is reported once and remembered, so it is not read again on every frame
+    inline const sf::Font* FontCache::get(const std::string& path)
+    {
+        Storage& cache = storage();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return load(cache, path);
+    }
+
+    // Find the font of a file in the cache or load it
+    inline const sf::Font* FontCache::load(Storage& cache, const std::string& path)
+    {
+        std::map<std::string, std::unique_ptr<sf::Font>>::iterator it = cache.fonts.find(path);
+        if (it == cache.fonts.end()) {
+            std::unique_ptr<sf::Font> font(new sf::Font());
+            if (!font->loadFromFile(path)) {
+                std::cerr << "Error loading font " << path << "\n";
+                font.reset();
+            }
+            it = cache.fonts.insert(std::make_pair(path, std::move(font))).first;
+        }
+        return it->second.get();
+    }
+
+    // Get the font of the default file
+    inline const sf::Font* FontCache::default_font()
+    {
+        Storage& cache = storage();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return load(cache, cache.defaultPath);
+    }
+
+    // Change the default font file - the fonts already loaded stay in the cache
+    inline void FontCache::set_default_path(const std::string& path)
+    {
+        Storage& cache = storage();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.defaultPath = path;
+    }
+
+    // Check if a file went through the cache - loaded or remembered as missing
+    inline bool FontCache::is_cached(const std::string& path)
+    {
+        Storage& cache = storage();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return cache.fonts.find(path) != cache.fonts.end();
+    }
+
+    // Get the default font file
+    inline std::string FontCache::default_path()
+    {
+        Storage& cache = storage();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return cache.defaultPath;
+    }
+
+    // Text of a label and its glyph quads - the text is formatted when the frame is built, the glyphs are laid out
+    // from the font only when the label is submitted to a render target (glyphs live in a GPU texture)
+    struct LabelText {
+        std::string text;  // The formatted key
+        std::vector<sf::Vertex> glyphs;  // Glyph quads relative to the label origin, empty until laid out and without a font
+        float width;  // Advance of the whole text, 0 until laid out
+        const sf::Font* font;  // Font the glyphs were laid out with - nullptr before
+    };
+
+    // Where a label of a frame goes - the key of a layout node, or the node count of the subtree collapsed at it
+    struct LabelPlacement {
+        size_t node;  // Index of the node in the layout
+        sf::Vector2f origin;  // Top left corner of the text - the center of the collapsed subtree for a count
+        float scale;  // Scale of the LabelSize glyphs
+        bool count;  // True for the node count of a collapsed subtree
+        LabelText* label;  // The text, owned by a LabelCache - valid until the cache drops it at the end of a later frame
+    };
+
+    // Geometry of a whole tree - every circle, edge and arrowhead goes into one of two vertex arrays,
+    // so a frame costs a few draw calls instead of several per node
+    // The shapes and label placements need no font, window or render context; the glyph quads are added
+    // from the placements when the geometry is submitted (buildGlyphs)
+    struct TreeGeometry {
+        sf::VertexArray triangles;  // Node circles, tessellated into triangles
+        sf::VertexArray lines;  // Edges and arrowheads
+        sf::VertexArray glyphs;  // Label glyph quads (two triangles each), textured from the font atlas - filled by buildGlyphs
+        std::vector<LabelPlacement> labels;  // Every label of the frame, in drawing order
+        const sf::Texture* glyphTexture;  // Font texture of the label size - nullptr without a font
+
+        TreeGeometry() : triangles(sf::Triangles), lines(sf::Lines), glyphs(sf::Triangles), glyphTexture(nullptr) {}
+        void clear() { triangles.clear(); lines.clear(); glyphs.clear(); labels.clear(); }  // Remove everything, keep the capacity
+    };
+
+    // Character size of the node labels
+    const unsigned LabelSize = 20;
+
+    // Number of points of a node circle - the sf::CircleShape default
+    const size_t CirclePoints = 30;
+
+    // Unit circle points, computed once - no trigonometry per node
+    struct UnitCircle {
+        sf::Vector2f points[CirclePoints + 1];  // The first point is repeated at the end
+
+        UnitCircle() {
+            for (size_t i = 0; i <= CirclePoints; ++i) {
+                float angle = static_cast<float>(i % CirclePoints) * 2 * 3.14159265359f / CirclePoints;
+                points[i] = sf::Vector2f(std::cos(angle), std::sin(angle));
+            }
+        }
+    };
+
+    // Get the unit circle points
+    inline const sf::Vector2f* unitCircle()
+    {
+        static const UnitCircle circle;
+        return circle.points;
+    }
+
+    // Append a filled circle as a fan of triangles around its center
+    inline void appendCircle(TreeGeometry& geometry, sf::Vector2f center, float radius, sf::Color color)
+    {
+        const sf::Vector2f* points = unitCircle();
+        for (size_t i = 0; i < CirclePoints; ++i) {
+            geometry.triangles.append(sf::Vertex(center, color));
+            geometry.triangles.append(sf::Vertex(center + points[i] * radius, color));
+            geometry.triangles.append(sf::Vertex(center + points[i + 1] * radius, color));
+        }
+    }
+
+    // Append a filled rectangle as two triangles
+    inline void appendRect(TreeGeometry& geometry, sf::Vector2f low, sf::Vector2f high, sf::Color color)
+    {
+        geometry.triangles.append(sf::Vertex(low, color));
+        geometry.triangles.append(sf::Vertex(sf::Vector2f(high.x, low.y), color));
+        geometry.triangles.append(sf::Vertex(sf::Vector2f(low.x, high.y), color));
+        geometry.triangles.append(sf::Vertex(sf::Vector2f(low.x, high.y), color));
+        geometry.triangles.append(sf::Vertex(sf::Vector2f(high.x, low.y), color));
+        geometry.triangles.append(sf::Vertex(high, color));
+    }
+
+    // Append an arrow between two points - the main line and the two lines of the arrowhead
+    inline void appendArrow(TreeGeometry& geometry, sf::Vector2f start, sf::Vector2f end)
+    {
+        // The main line of the arrow
+        geometry.lines.append(sf::Vertex(start));
+        geometry.lines.append(sf::Vertex(end));
+
+        // Calculate the direction vector from start to end
+        sf::Vector2f direction = end - start;
+
+        // Calculate the length of the direction vector
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        if (length == 0) return;
+
+        // Normalize the direction vector to unit length
+        direction /= length;
+
+        // Set the size of the arrowhead
+        float arrowSize = 10.0f;
+
+        // Calculate the points for the arrowhead
+        // The arrowhead is created by taking the direction vector and adjusting it perpendicularly
+        sf::Vector2f arrowPoint1 = end - direction * arrowSize + sf::Vector2f(-direction.y, direction.x) * arrowSize * 0.5f;
+        sf::Vector2f arrowPoint2 = end - direction * arrowSize + sf::Vector2f(direction.y, -direction.x) * arrowSize * 0.5f;
+
+        // The arrowhead
+        geometry.lines.append(sf::Vertex(end));
+        geometry.lines.append(sf::Vertex(arrowPoint1));
+        geometry.lines.append(sf::Vertex(end));
+        geometry.lines.append(sf::Vertex(arrowPoint2));
+    }
+
+    // Function to draw an arrow between two points in a GUI window using SFML - one draw call
+    inline void drawArrow(sf::RenderTarget &window, sf::Vector2f start, sf::Vector2f end)
+    {
+        TreeGeometry geometry;
+        appendArrow(geometry, start, end);
+        window.draw(geometry.lines);
+    }
+
+    // Draw the geometry - circles first, then the edges (the arrowheads end on the child circles), then the labels
+    // Every label glyph comes from the same font texture, so all the labels are one draw call
+    inline void drawGeometry(sf::RenderTarget& window, const TreeGeometry& geometry)
+    {
+        window.draw(geometry.triangles);
+        window.draw(geometry.lines);
+        if (geometry.glyphTexture && geometry.glyphs.getVertexCount() > 0) {
+            window.draw(geometry.glyphs, sf::RenderStates(geometry.glyphTexture));
+        }
+    }
+
+    // Node labels - each key is formatted once and kept with its glyph quads (positions relative to the label
+    // origin, texture coordinates in the font atlas, laid out by buildGlyphs). A label is formatted again only when
+    // the key of its node changes, and the labels of nodes that were not drawn in the last frame are dropped.
+    // The cache itself never touches a font.
+    template <typename Handle, typename Key>
+    class LabelCache {
+    public:
+        struct Label : LabelText {
+            Key key;  // The key the label was made from
+            size_t frame;  // Last frame the label was used in
+        };
+
+        LabelCache();  // Constructor - empty cache
+
+        Label& get(Handle node, const Key& key);  // The label of a node - formatted when missing or when the key changed
+        void next_frame();  // End a frame - drop the labels that were not used in it
+        size_t size() const;  // Number of cached labels
+        size_t formatted() const;  // Number of labels formatted so far (cache misses)
+        void clear();  // Remove every label
+
+    private:
+        std::unordered_map<Handle, Label> labels;  // Labels by node
+        size_t frame;  // Current frame
+        size_t used;  // Labels used in the current frame
+        size_t misses;  // Labels formatted so far
+    };
+
+    // Constructor
+    template <typename Handle, typename Key>
+    LabelCache<Handle, Key>::LabelCache() : frame(0), used(0), misses(0) {}
+
+    // Get the label of a node - the key is compared with the cached key, and formatted with operator<< only if it changed
+    template <typename Handle, typename Key>
+    typename LabelCache<Handle, Key>::Label& LabelCache<Handle, Key>::get(Handle node, const Key& key)
+    {
+        typename std::unordered_map<Handle, Label>::iterator it = labels.find(node);
+        if (it == labels.end() || !(it->second.key == key)) {
+            std::ostringstream oss;
+            oss << key;
+            Label label;
+            label.text = oss.str();
+            label.width = 0;
+            label.font = nullptr;
+            label.key = key;
+            label.frame = it == labels.end() ? static_cast<size_t>(-1) : it->second.frame;
+            if (it == labels.end()) {
+                it = labels.insert(std::make_pair(node, std::move(label))).first;
+            } else {
+                it->second = std::move(label);
+            }
+            misses++;
+        }
+        if (it->second.frame != frame) {
+            it->second.frame = frame;
+            used++;
+        }
+        return it->second;
+    }
+
+    // End a frame - when most cached labels belong to nodes that were not drawn (deleted nodes, a smaller tree),
+    // drop them so the cache stays proportional to the tree
+    template <typename Handle, typename Key>
+    void LabelCache<Handle, Key>::next_frame()
+    {
+        if (labels.size() > 2 * used + 64) {
+            for (typename std::unordered_map<Handle, Label>::iterator it = labels.begin(); it != labels.end();) {
+                if (it->second.frame != frame) {
+                    it = labels.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        frame++;
+        used = 0;
+    }
+
+    // Get the number of cached labels
+    template <typename Handle, typename Key>
+    size_t LabelCache<Handle, Key>::size() const
+    {
+        return labels.size();
+    }
+
+    // Get the number of labels formatted so far
+    template <typename Handle, typename Key>
+    size_t LabelCache<Handle, Key>::formatted() const
+    {
+        return misses;
+    }
+
+    // Remove every label
+    template <typename Handle, typename Key>
+    void LabelCache<Handle, Key>::clear()
+    {
+        labels.clear();
+        used = 0;
+    }
+
+    // Lay out the glyphs of a label the way sf::Text does - the baseline is one character size below the origin,
+    // each glyph is a quad of two triangles with the texture rectangle of the glyph in the font atlas
+    // Kept until the font changes; sf::Font::getGlyph renders into the font texture, so this needs a render context
+    inline void layoutGlyphs(LabelText& label, const sf::Font* font)
+    {
+        if (label.font == font) return;
+        label.font = font;
+        label.glyphs.clear();
+        label.width = 0;
+        if (!font) return;
+        float x = 0;
+        float y = static_cast<float>(LabelSize);
+        sf::Uint32 previous = 0;
+        for (char ch : label.text) {
+            sf::Uint32 current = static_cast<unsigned char>(ch);
+            x += font->getKerning(previous, current, LabelSize);
+            previous = current;
+
+            const sf::Glyph& glyph = font->getGlyph(current, LabelSize, false);
+            if (ch != ' ') {
+                float left = x + glyph.bounds.left;
+                float top = y + glyph.bounds.top;
+                float right = left + glyph.bounds.width;
+                float bottom = top + glyph.bounds.height;
+                float u1 = static_cast<float>(glyph.textureRect.left);
+                float v1 = static_cast<float>(glyph.textureRect.top);
+                float u2 = u1 + glyph.textureRect.width;
+                float v2 = v1 + glyph.textureRect.height;
+
+                const sf::Vertex quad[6] = {
+                    sf::Vertex(sf::Vector2f(left, top), sf::Color::White, sf::Vector2f(u1, v1)),
+                    sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u2, v1)),
+                    sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u1, v2)),
+                    sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u1, v2)),
+                    sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u2, v1)),
+                    sf::Vertex(sf::Vector2f(right, bottom), sf::Color::White, sf::Vector2f(u2, v2))
+                };
+                label.glyphs.insert(label.glyphs.end(), quad, quad + 6);
+            }
+            x += glyph.advance;
+        }
+        label.width = x;
+    }
+
+    // Fill the glyph quads of the geometry from its label placements with the default font - the submission side
+    // of a frame. Node counts are centered on their placement once their width is known.
+    inline void buildGlyphs(TreeGeometry& geometry)
+    {
+        const sf::Font* font = FontCache::default_font();
+        geometry.glyphs.clear();
+        geometry.glyphTexture = font ? &font->getTexture(LabelSize) : nullptr;
+        if (!font) return;
+        for (const LabelPlacement& placement : geometry.labels) {
+            LabelText& label = *placement.label;
+            layoutGlyphs(label, font);
+            sf::Vector2f origin = placement.origin;
+            if (placement.count) {
+                origin -= sf::Vector2f(label.width, LabelSize) * (placement.scale / 2);
+            }
+            for (const sf::Vertex& vertex : label.glyphs) {
+                geometry.glyphs.append(sf::Vertex(vertex.position * placement.scale + origin, vertex.color, vertex.texCoords));
+            }
+        }
+    }
+
+    // ******Shapes******
+    // The layout (TreeLayout.hpp) is computed again only after the tree changes
+    // (TreeRenderer::invalidate) or when the size of the render target changes;
+    // the shapes are built from its LayoutIndex for the visible rectangle only.
+
+    const float NodeRadius = 20;  // Radius of a node circle
+    const float AggregatePixels = 32;  // A subtree smaller than this on screen is drawn as one shape with its node count
+    const float LabelPixels = 8;  // Labels smaller than this on screen are not drawn
+    const float CountPixels = 12;  // Character size of the node counts on screen
+    const sf::Color AggregateColor(60, 60, 200);  // Color of a collapsed subtree
+
+    // Build the circles, edges and arrowheads of a layout - they change only with the layout
+    template <typename Handle>
+    void buildShapes(const TreeLayout<Handle>& layout, TreeGeometry& geometry)
+    {
+        geometry.triangles.clear();
+        geometry.lines.clear();
+        for (const LayoutNode& node : layout.nodes) {
+            appendCircle(geometry, node.position, NodeRadius, sf::Color::Blue);
+            if (node.parent != NoParent) {
+                appendArrow(geometry, layout.nodes[node.parent].position, node.position);
+            }
+        }
+    }
+
+    // Build the circles, edges and arrowheads of the visible part of a layout (LayoutIndex::query)
+    // Edge candidates are checked against the rectangle by their bounding box
+    template <typename Handle>
+    void buildShapes(const TreeLayout<Handle>& layout, const std::vector<LayoutRange>& nodes, const std::vector<LayoutRange>& edges, const sf::FloatRect& rect, TreeGeometry& geometry)
+    {
+        geometry.triangles.clear();
+        geometry.lines.clear();
+        for (const LayoutRange& range : nodes) {
+            for (size_t i = range.begin; i < range.end; ++i) {
+                appendCircle(geometry, layout.nodes[i].position, NodeRadius, sf::Color::Blue);
+            }
+        }
+        for (const LayoutRange& range : edges) {
+            for (size_t i = range.begin; i < range.end; ++i) {
+                sf::Vector2f end = layout.nodes[i].position;
+                sf::Vector2f start = layout.nodes[layout.nodes[i].parent].position;
+                sf::FloatRect bounds(std::min(start.x, end.x), start.y, std::abs(end.x - start.x) + 1, end.y - start.y);
+                if (bounds.intersects(rect)) {
+                    appendArrow(geometry, start, end);
+                }
+            }
+        }
+    }
+
+    // Build the shapes of a level-of-detail selection (LayoutIndex::select) - the nodes, a rectangle over
+    // the bounds of every collapsed subtree, and the edges
+    template <typename Handle>
+    void buildShapes(const TreeLayout<Handle>& layout, const std::vector<SubtreeSummary>& subtrees, const DetailSelection& selection, TreeGeometry& geometry)
+    {
+        geometry.triangles.clear();
+        geometry.lines.clear();
+        for (size_t i : selection.nodes) {
+            appendCircle(geometry, layout.nodes[i].position, NodeRadius, sf::Color::Blue);
+        }
+        for (size_t i : selection.aggregates) {
+            sf::Vector2f margin(NodeRadius, NodeRadius);
+            appendRect(geometry, subtrees[i].low - margin, subtrees[i].high + margin, AggregateColor);
+        }
+        for (size_t i : selection.edges) {
+            appendArrow(geometry, layout.nodes[layout.nodes[i].parent].position, layout.nodes[i].position);
+        }
+    }
+
+    // Build the label placements of a level-of-detail selection - the node count of every collapsed subtree
+    // at CountPixels on screen, and the node labels when 'nodeLabels' is true
+    template <typename View, typename Labels, typename Counts>
+    void buildLabels(const TreeLayout<typename View::Handle>& layout, const std::vector<SubtreeSummary>& subtrees, const DetailSelection& selection,
+                     const View& view, Labels& labels, Counts& counts, float pixels, bool nodeLabels, TreeGeometry& geometry)
+    {
+        geometry.glyphs.clear();
+        geometry.labels.clear();
+        if (nodeLabels) {
+            for (size_t i : selection.nodes) {
+                sf::Vector2f position = layout.nodes[i].position;
+                sf::Vector2f origin(position.x - NodeRadius / 2, position.y - NodeRadius / 2);
+                LabelText& label = labels.get(layout.handles[i], view.key(layout.handles[i]));
+                geometry.labels.push_back(LabelPlacement{i, origin, 1, false, &label});
+            }
+        }
+        float scale = CountPixels / (LabelSize * pixels);
+        for (size_t i : selection.aggregates) {
+            const SubtreeSummary& subtree = subtrees[i];
+            LabelText& label = counts.get(i, subtree.count);
+            sf::Vector2f center = (subtree.low + subtree.high) / 2.0f;
+            geometry.labels.push_back(LabelPlacement{i, center, scale, true, &label});
+        }
+    }
+
+    // Build the label placements of a layout - the keys are compared with the cached labels, no formatting for unchanged keys
+    template <typename View, typename Labels>
+    void buildLabels(const TreeLayout<typename View::Handle>& layout, const View& view, Labels& labels, TreeGeometry& geometry)
+    {
+        buildLabels(layout, std::vector<LayoutRange>(1, LayoutRange{0, layout.size()}), view, labels, geometry);
+    }
+
+    // Build the label placements of the visible nodes of a layout
+    template <typename View, typename Labels>
+    void buildLabels(const TreeLayout<typename View::Handle>& layout, const std::vector<LayoutRange>& nodes, const View& view, Labels& labels, TreeGeometry& geometry)
+    {
+        geometry.glyphs.clear();
+        geometry.labels.clear();
+        for (const LayoutRange& range : nodes) {
+            for (size_t i = range.begin; i < range.end; ++i) {
+                sf::Vector2f position = layout.nodes[i].position;
+                sf::Vector2f origin(position.x - NodeRadius / 2, position.y - NodeRadius / 2);
+                LabelText& label = labels.get(layout.handles[i], view.key(layout.handles[i]));
+                geometry.labels.push_back(LabelPlacement{i, origin, 1, false, &label});
+            }
+        }
+    }
+
+    // Draws one tree frame after frame and keeps what can be reused between frames:
+    // the layout and its spatial index, the circle and edge geometry, and the node labels
+    // Only the nodes and edges inside the target's current sf::View are built and drawn, so zooming and panning
+    // cost O(visible) per frame however large the tree is. Zoomed out, subtrees smaller than AggregatePixels
+    // are drawn as one rectangle with their node count, and labels smaller than LabelPixels are hidden.
+    // A frame has two stages: build() turns the tree into vertex arrays and label placements for a target size and
+    // sf::View - no window, font or render context needed - and submit() lays out the label glyphs from the font and
+    // hands everything to any sf::RenderTarget in three draw calls.
+    // The owner of the tree calls invalidate() after every change of the tree shape.
+    // draw, build, submit, invalidate and read_layout hold the renderer's mutex, so a const tree can be drawn and
+    // exported from several threads; the references returned by the accessors are not guarded and are only valid
+    // until the next frame.
+    template <typename View>
+    class TreeRenderer {
+    public:
+        typedef typename View::Handle Handle;
+        typedef typename std::decay<decltype(std::declval<const View&>().key(std::declval<Handle>()))>::type Key;
+        typedef LabelCache<Handle, Key> Labels;
+
+        TreeRenderer();  // Constructor - nothing laid out yet
+
+        void draw(sf::RenderTarget& window, const View& view);  // Build and submit a frame for the target's size and view
+        void build(sf::Vector2u size, const sf::View& camera, const View& view);  // Build the geometry of a frame for a target of 'size' pixels showing 'camera'
+        void submit(sf::RenderTarget& target);  // Add the label glyphs and draw the geometry of the last frame
+        void invalidate();  // The tree shape changed - compute the layout again on the next frame
+        template <typename Read>
+        void read_layout(const View& view, Read read);  // Call read(layout) with the layout brought up to date, no frame is built meanwhile
+        const TreeLayout<Handle>& layout() const;  // Layout of the last frame
+        const LayoutIndex& index() const;  // Spatial index of the layout
+        const std::vector<LayoutRange>& visible() const;  // Nodes drawn in the last frame (full detail)
+        const DetailSelection& detail() const;  // Nodes and aggregates drawn in the last frame (zoomed out)
+        const TreeGeometry& geometry() const;  // Geometry of the last frame
+        const Labels& labels() const;  // Cached labels
+        size_t layout_count() const;  // Number of times the layout was computed
+
+    private:
+        TreeLayout<Handle> nodeLayout;  // Node positions
+        LayoutIndex nodeIndex;  // Rows of the layout for culling
+        std::vector<LayoutRange> visibleNodes;  // Nodes inside the visible rectangle
+        std::vector<LayoutRange> visibleEdges;  // Children of the edges that may cross the visible rectangle
+        DetailSelection selection;  // Level-of-detail selection of a zoomed out view
+        sf::FloatRect shown;  // Visible rectangle the shapes were built for
+        TreeGeometry lastGeometry;  // Vertex arrays - shapes kept while the layout and the view are the same, glyphs rebuilt every frame
+        Labels labelCache;  // Node labels
+        LabelCache<size_t, size_t> countCache;  // Node counts of the collapsed subtrees, by layout index
+        sf::Vector2u area;  // Size of the render target the layout was computed for
+        bool dirty;  // True when the layout must be computed again
+        bool shapesValid;  // True while the shapes match the layout and the visible rectangle
+        size_t layouts;  // Number of layouts computed
+        std::mutex mutex;  // Held while a frame is built or submitted and while the layout is read
+
+        void buildFrame(sf::Vector2u size, const sf::View& camera, const View& view);  // build() with the mutex held
+        void layoutIfDirty(const View& view);  // Compute the layout if the tree changed, the mutex is held by the caller
+    };
+
+    // Constructor
+    template <typename View>
+    TreeRenderer<View>::TreeRenderer() : dirty(true), shapesValid(false), layouts(0) {}
+
+    // Function to draw the tree in the specified SFML window
+    template <typename View>
+    void TreeRenderer<View>::draw(sf::RenderTarget &window, const View& view)
+    {
+        try {
+            std::lock_guard<std::mutex> lock(mutex);
+            buildFrame(window.getSize(), window.getView(), view);
+            buildGlyphs(lastGeometry);
+            drawGeometry(window, lastGeometry);
+        }
+        catch (const std::exception& e) {
+            // Catch and print any exceptions that occur during drawing
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    // Build the geometry of a frame
+    // The layout is reused while the tree and the target size stay the same, and the shapes while the view stays the same too,
+    // so an unchanged frame costs one key comparison and one label copy per visible node - no trigonometry
+    template <typename View>
+    void TreeRenderer<View>::build(sf::Vector2u size, const sf::View& camera, const View& view)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buildFrame(size, camera, view);
+    }
+
+    // Build the geometry of a frame - the mutex is held by the caller
+    template <typename View>
+    void TreeRenderer<View>::buildFrame(sf::Vector2u size, const sf::View& camera, const View& view)
+    {
+        if (size != area) {
+            area = size;
+            dirty = true;
+        }
+        layoutIfDirty(view);
+        sf::FloatRect rect = viewRect(camera);
+        float pixels = size.x / rect.width;  // Pixels per world unit
+
+        // The smallest subtree with children is one level deep - if it is big enough on screen nothing is collapsed
+        bool aggregate = (LevelSpacing + 2 * NodeRadius) * pixels < AggregatePixels;
+        if (!shapesValid || rect != shown) {
+            if (aggregate) {
+                visibleNodes.clear();
+                nodeIndex.select(nodeLayout, rect, NodeRadius, AggregatePixels / pixels, selection);
+                buildShapes(nodeLayout, nodeIndex.subtrees(), selection, lastGeometry);
+            } else {
+                selection.clear();
+                nodeIndex.query(nodeLayout, rect, NodeRadius, visibleNodes, visibleEdges);
+                buildShapes(nodeLayout, visibleNodes, visibleEdges, rect, lastGeometry);
+            }
+            shown = rect;
+            shapesValid = true;
+        }
+
+        bool nodeLabels = LabelSize * pixels >= LabelPixels;
+        if (aggregate) {
+            buildLabels(nodeLayout, nodeIndex.subtrees(), selection, view, labelCache, countCache, pixels, nodeLabels, lastGeometry);
+        } else if (nodeLabels) {
+            buildLabels(nodeLayout, visibleNodes, view, labelCache, lastGeometry);
+        } else {
+            lastGeometry.glyphs.clear();  // glyphs of the last submission
+            lastGeometry.labels.clear();
+        }
+        labelCache.next_frame();
+        countCache.next_frame();
+    }
+
+    // Draw the geometry of the last frame - the target's view must be the one the frame was built for
+    // The glyphs of the labels are laid out here, where a render context exists
+    template <typename View>
+    void TreeRenderer<View>::submit(sf::RenderTarget& target)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buildGlyphs(lastGeometry);
+        drawGeometry(target, lastGeometry);
+    }
+
+    // Mark the layout as stale
+    template <typename View>
+    void TreeRenderer<View>::invalidate()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dirty = true;
+    }
+
+    // Read the layout for the target size of the last frame, computed now if the tree changed - the mutex is held
+    // until 'read' returns, so another thread drawing the same tree waits instead of moving the nodes under it
+    template <typename View>
+    template <typename Read>
+    void TreeRenderer<View>::read_layout(const View& view, Read read)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        layoutIfDirty(view);
+        read(static_cast<const TreeLayout<Handle>&>(nodeLayout));
+    }
+
+    // Lay the tree out again if it changed since the last layout - the layout and its index stay cached for the next frame
+    template <typename View>
+    void TreeRenderer<View>::layoutIfDirty(const View& view)
+    {
+        if (dirty) {
+            layoutTree(view, area, nodeLayout);
+            nodeIndex.build(nodeLayout);
+            dirty = false;
+            shapesValid = false;
+            layouts++;
+        }
+    }
+
+    // Get the layout of the last frame
+    template <typename View>
+    const TreeLayout<typename TreeRenderer<View>::Handle>& TreeRenderer<View>::layout() const
+    {
+        return nodeLayout;
+    }
+
+    // Get the spatial index of the layout
+    template <typename View>
+    const LayoutIndex& TreeRenderer<View>::index() const
+    {
+        return nodeIndex;
+    }
+
+    // Get the nodes drawn in the last frame
+    template <typename View>
+    const std::vector<LayoutRange>& TreeRenderer<View>::visible() const
+    {
+        return visibleNodes;
+    }
+
+    // Get the level-of-detail selection of the last frame
+    template <typename View>
+    const DetailSelection& TreeRenderer<View>::detail() const
+    {
+        return selection;
+    }
+
+    // Get the number of layouts computed
+    template <typename View>
+    size_t TreeRenderer<View>::layout_count() const
+    {
+        return layouts;
+    }
+
+    // Get the geometry of the last frame
+    template <typename View>
+    const TreeGeometry& TreeRenderer<View>::geometry() const
+    {
+        return lastGeometry;
+    }
+
+    // Get the cached labels
+    template <typename View>
+    const typename TreeRenderer<View>::Labels& TreeRenderer<View>::labels() const
+    {
+        return labelCache;
+    }
+
+    // Function to draw the tree in the specified SFML window, without keeping anything for the next frame
+    template <typename View>
+    void drawTree(sf::RenderTarget &window, const View& view)
+    {
+        TreeRenderer<View> renderer;
+        renderer.draw(window, view);
+    }
+
+}
+
+#endif
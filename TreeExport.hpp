@@ -0,0 +1,297 @@
+#ifndef TREE_EXPORT_HPP
+#define TREE_EXPORT_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <locale>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "TreeLayout.hpp"
+#include "TreeDrawing.hpp"
+
+namespace ariel {
+
+    // ******Text export******
+    // SVG documents of the viewer's layout (and the DOT and text output of Tree), written node by node into a fixed
+    // size buffer that is handed to the stream when it is full - no document is built in memory, and the stream sees
+    // a few large writes instead of one small write per node.
+
+    const size_t ExportBufferSize = 1 << 16;  // Bytes collected before a write to the stream
+
+    // Fixed size output buffer in front of an std::ostream, flushed to the stream when full and on destruction
+    class BufferedWriter {
+    public:
+        explicit BufferedWriter(std::ostream& out, size_t capacity = ExportBufferSize);  // Constructor
+        ~BufferedWriter();  // Destructor - writes what is left in the buffer
+        BufferedWriter(const BufferedWriter&) = delete;
+        BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+        void write(const char* data, size_t length);  // Raw bytes
+        BufferedWriter& operator<<(const char* text);  // C string
+        BufferedWriter& operator<<(const std::string& text);  // String
+        BufferedWriter& operator<<(char c);  // One character
+        BufferedWriter& operator<<(size_t value);  // Unsigned integer
+        BufferedWriter& operator<<(float value);  // Shortest text that reads back as the same float
+        void write_xml(const std::string& text);  // Text with the XML special characters escaped
+        void write_quoted(const std::string& text);  // Text with '"' and '\' escaped, for a DOT string
+        void flush();  // Write the buffer to the stream (the stream itself is not flushed)
+
+    private:
+        std::ostream& out;  // Destination
+        std::vector<char> buffer;  // Pending bytes
+        size_t used;  // Number of pending bytes
+
+        char* reserve(size_t length);  // Room for 'length' bytes at the end of the buffer (length <= capacity)
+    };
+
+    // The text operator<< prints for a key, without a stream for the arithmetic types
+    class KeyFormatter {
+    public:
+        KeyFormatter();  // Constructor - the default stream format
+        explicit KeyFormatter(const std::ostream& like);  // Constructor - the format flags and precision of a stream
+
+        template <typename Key>
+        const std::string& operator()(const Key& key);  // Text of a key - valid until the next call
+
+    private:
+        std::string text;  // Last text
+        std::ostringstream stream;  // Reused for the other key types
+        bool fast;  // True if std::to_chars prints numbers like the stream (default flags and precision)
+    };
+
+    // Write a laid out tree as an SVG document - the circles, edges, arrowheads and labels of the viewer,
+    // in its drawing order, on its black background. The layout is read as it is (the renderer's cached layout,
+    // or one from layoutTree), the writer adds only its fixed buffer.
+    template <typename View>
+    void writeSvg(const TreeLayout<typename View::Handle>& layout, const View& view, std::ostream& out);
+
+
+    // ********** Implementations **********
+
+
+    // Constructor
+    inline BufferedWriter::BufferedWriter(std::ostream& out, size_t capacity) : out(out), buffer(std::max<size_t>(capacity, 64)), used(0) {}
+
+    // Destructor
+    inline BufferedWriter::~BufferedWriter()
+    {
+        flush();
+    }
+
+    // Raw bytes - copied into the buffer, or straight to the stream if they do not fit into an empty buffer
+    inline void BufferedWriter::write(const char* data, size_t length)
+    {
+        if (used + length > buffer.size()) {
+            flush();
+            if (length > buffer.size()) {
+                out.write(data, static_cast<std::streamsize>(length));
+                return;
+            }
+        }
+        std::memcpy(buffer.data() + used, data, length);
+        used += length;
+    }
+
+    inline BufferedWriter& BufferedWriter::operator<<(const char* text)
+    {
+        write(text, std::strlen(text));
+        return *this;
+    }
+
+    inline BufferedWriter& BufferedWriter::operator<<(const std::string& text)
+    {
+        write(text.data(), text.size());
+        return *this;
+    }
+
+    inline BufferedWriter& BufferedWriter::operator<<(char c)
+    {
+        *reserve(1) = c;
+        ++used;
+        return *this;
+    }
+
+    inline BufferedWriter& BufferedWriter::operator<<(size_t value)
+    {
+        char* begin = reserve(24);
+        used = std::to_chars(begin, begin + 24, value).ptr - buffer.data();
+        return *this;
+    }
+
+    inline BufferedWriter& BufferedWriter::operator<<(float value)
+    {
+        char* begin = reserve(32);
+        used = std::to_chars(begin, begin + 32, value).ptr - buffer.data();
+        return *this;
+    }
+
+    // Escape &, <, > and quotes for element text and attribute values
+    inline void BufferedWriter::write_xml(const std::string& text)
+    {
+        size_t start = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const char* entity = nullptr;
+            switch (text[i]) {
+                case '&': entity = "&amp;"; break;
+                case '<': entity = "&lt;"; break;
+                case '>': entity = "&gt;"; break;
+                case '"': entity = "&quot;"; break;
+                case '\'': entity = "&apos;"; break;
+                default: continue;
+            }
+            write(text.data() + start, i - start);
+            *this << entity;
+            start = i + 1;
+        }
+        write(text.data() + start, text.size() - start);
+    }
+
+    // Escape the quote and the backslash inside a double quoted DOT string, and keep line breaks on one line
+    inline void BufferedWriter::write_quoted(const std::string& text)
+    {
+        size_t start = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            if (c != '"' && c != '\\' && c != '\n') continue;
+            write(text.data() + start, i - start);
+            *this << (c == '\n' ? "\\n" : c == '"' ? "\\\"" : "\\\\");
+            start = i + 1;
+        }
+        write(text.data() + start, text.size() - start);
+    }
+
+    inline void BufferedWriter::flush()
+    {
+        if (used == 0) return;
+        out.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+
+    inline char* BufferedWriter::reserve(size_t length)
+    {
+        if (used + length > buffer.size()) flush();
+        return buffer.data() + used;
+    }
+
+    // Constructor
+    inline KeyFormatter::KeyFormatter() : fast(true) {}
+
+    // Constructor - numbers leave the fast path if the stream was set to another base, fixed, showpos...
+    inline KeyFormatter::KeyFormatter(const std::ostream& like)
+    {
+        stream.copyfmt(like);
+        stream.width(0);
+        fast = stream.flags() == (std::ios_base::dec | std::ios_base::skipws) && stream.precision() == 6 && like.getloc() == std::locale::classic();
+    }
+
+    // Integers with std::to_chars, floating point keys in the default stream format (%g, 6 digits),
+    // everything else (bool, characters, Complex, strings...) through operator<<
+    template <typename Key>
+    const std::string& KeyFormatter::operator()(const Key& key)
+    {
+        typedef typename std::remove_cv<Key>::type Type;
+        const bool character = std::is_same<Type, bool>::value || std::is_same<Type, char>::value ||
+                               std::is_same<Type, signed char>::value || std::is_same<Type, unsigned char>::value;
+        if constexpr (std::is_arithmetic<Type>::value && !character) {
+            if (!fast) {
+                stream.str(std::string());
+                stream << key;
+                text = stream.str();
+                return text;
+            }
+            char digits[64];
+            std::to_chars_result result;
+            if constexpr (std::is_floating_point<Type>::value) {
+                result = std::to_chars(digits, digits + sizeof(digits), key, std::chars_format::general, 6);
+            } else {
+                result = std::to_chars(digits, digits + sizeof(digits), key);
+            }
+            text.assign(digits, result.ptr);
+        } else {
+            stream.str(std::string());
+            stream << key;
+            text = stream.str();
+        }
+        return text;
+    }
+
+    // Write an SVG document
+    /*
+        Step 1: Find the bounds of the drawing for the viewBox
+        Step 2: One group per primitive - circles, then edge paths with their arrowheads, then labels,
+                the same order as drawGeometry so labels stay on top
+    */
+    template <typename View>
+    void writeSvg(const TreeLayout<typename View::Handle>& layout, const View& view, std::ostream& out)
+    {
+        BufferedWriter writer(out);
+        KeyFormatter format;
+
+        // Step 1: Bounds of every circle (the arrowheads and labels stay inside them)
+        sf::Vector2f low(0, 0), high(0, 0);
+        for (size_t i = 0; i < layout.size(); ++i) {
+            sf::Vector2f p = layout.nodes[i].position;
+            if (i == 0 || p.x < low.x) low.x = p.x;
+            if (i == 0 || p.y < low.y) low.y = p.y;
+            if (i == 0 || p.x > high.x) high.x = p.x;
+            if (i == 0 || p.y > high.y) high.y = p.y;
+        }
+        low -= sf::Vector2f(NodeRadius, NodeRadius);
+        high += sf::Vector2f(NodeRadius, NodeRadius);
+        float width = layout.size() > 0 ? high.x - low.x : 0;
+        float height = layout.size() > 0 ? high.y - low.y : 0;
+
+        writer << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height
+               << "\" viewBox=\"" << low.x << ' ' << low.y << ' ' << width << ' ' << height << "\">\n"
+               << "<rect x=\"" << low.x << "\" y=\"" << low.y << "\" width=\"" << width << "\" height=\"" << height << "\" fill=\"black\"/>\n";
+
+        // Step 2: Circles
+        writer << "<g fill=\"blue\">\n";
+        for (size_t i = 0; i < layout.size(); ++i) {
+            sf::Vector2f p = layout.nodes[i].position;
+            writer << "<circle cx=\"" << p.x << "\" cy=\"" << p.y << "\" r=\"" << NodeRadius << "\"/>\n";
+        }
+        writer << "</g>\n";
+
+        // Edges - the line from the parent and the two strokes of the arrowhead in one path
+        const float arrowSize = 10.0f;
+        writer << "<g stroke=\"white\" fill=\"none\">\n";
+        for (size_t i = 1; i < layout.size(); ++i) {
+            sf::Vector2f start = layout.nodes[layout.nodes[i].parent].position;
+            sf::Vector2f end = layout.nodes[i].position;
+            writer << "<path d=\"M" << start.x << ' ' << start.y << 'L' << end.x << ' ' << end.y;
+            sf::Vector2f direction = end - start;
+            float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+            if (length > 0) {
+                direction /= length;
+                sf::Vector2f side(-direction.y, direction.x);
+                sf::Vector2f head1 = end - direction * arrowSize + side * arrowSize * 0.5f;
+                sf::Vector2f head2 = end - direction * arrowSize - side * arrowSize * 0.5f;
+                writer << 'M' << head1.x << ' ' << head1.y << 'L' << end.x << ' ' << end.y << 'L' << head2.x << ' ' << head2.y;
+            }
+            writer << "\"/>\n";
+        }
+        writer << "</g>\n";
+
+        // Labels - the viewer puts the top left corner of the text at (x - r/2, y - r/2), SVG places the baseline
+        float baseline = LabelSize * 0.8f;
+        writer << "<g fill=\"white\" font-family=\"sans-serif\" font-size=\"" << static_cast<size_t>(LabelSize) << "\">\n";
+        for (size_t i = 0; i < layout.size(); ++i) {
+            sf::Vector2f p = layout.nodes[i].position;
+            writer << "<text x=\"" << p.x - NodeRadius / 2 << "\" y=\"" << p.y - NodeRadius / 2 + baseline << "\">";
+            writer.write_xml(format(view.key(layout.handles[i])));
+            writer << "</text>\n";
+        }
+        writer << "</g>\n</svg>\n";
+    }
+
+}
+
+#endif
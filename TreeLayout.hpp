@@ -0,0 +1,512 @@
+#ifndef TREE_LAYOUT_HPP
+#define TREE_LAYOUT_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <SFML/Graphics.hpp>
+
+namespace ariel {
+
+    // ******Layout******
+    // The layout stage computes the position of every node once and stores it in a contiguous buffer;
+    // the render stage (TreeDrawing.hpp) reads the buffer. Trees are read through the same view as the drawing functions.
+
+    const size_t NoParent = static_cast<size_t>(-1);  // Parent index of the root
+    const float NodeSpacing = 50;  // Horizontal distance between two neighbouring nodes of a level
+    const float LevelSpacing = 80;  // Vertical distance between two levels
+    const float RootTop = 50;  // Distance of the root from the top of the render target
+
+    // Position of a node in a layout and the index of its parent in the same layout
+    struct LayoutNode {
+        sf::Vector2f position;  // Center of the node
+        size_t parent;  // Index of the parent node, NoParent for the root
+    };
+
+    // Positions of every node of a tree in BFS order - the children of a node are contiguous,
+    // and the nodes of each level are sorted from left to right
+    template <typename Handle>
+    struct TreeLayout {
+        std::vector<LayoutNode> nodes;  // Node positions and parents
+        std::vector<Handle> handles;  // Handle of every node, same order - used for the keys of the labels
+
+        void clear() { nodes.clear(); handles.clear(); }  // Remove every node, keep the capacity
+        size_t size() const { return nodes.size(); }  // Number of nodes
+    };
+
+    // Tidy tree layout - Buchheim, Junger and Leipert's linear time version of Walker's algorithm, for any number of children
+    // Every subtree is laid out once, then placed as close to its left siblings as their contours allow
+    // (one unit between neighbouring nodes of a level), and a parent is centered above its first and last child.
+    // Subtrees never overlap, identical subtrees get identical drawings, and the work is O(n).
+    // The tree is given in BFS order (children contiguous), so both walks are loops over the arrays - no recursion.
+    class TidyLayout {
+    public:
+        // Compute the x coordinate (in units) of every node - the parent, first child and child count arrays are in BFS order
+        void compute(const std::vector<size_t>& parents, const std::vector<size_t>& firstChildren, const std::vector<size_t>& childCounts, std::vector<double>& x);
+
+    private:
+        const std::vector<size_t>* parent;  // Parent of every node
+        const std::vector<size_t>* firstChild;  // First child of every node
+        const std::vector<size_t>* childCount;  // Number of children of every node
+        std::vector<size_t> number;  // Position of a node among its siblings
+        std::vector<size_t> thread;  // Contour thread - the next node of a contour that is not a child
+        std::vector<size_t> ancestor;  // Ancestor used to find the subtree to move
+        std::vector<double> prelim;  // Preliminary x relative to the parent
+        std::vector<double> mod;  // Shift of the whole subtree, added to the descendants in the second walk
+        std::vector<double> change;  // Shift changes of the siblings between moved subtrees
+        std::vector<double> shift;  // Shifts waiting to be spread over the siblings
+        std::vector<double> middle;  // Center of the children of a node
+
+        size_t nextLeft(size_t v) const;  // Next node of the left contour
+        size_t nextRight(size_t v) const;  // Next node of the right contour
+        bool hasLeftSibling(size_t v) const;  // True if the node is not the first child
+        void place(size_t v);  // Place a node next to its left sibling
+        size_t apportion(size_t v, size_t defaultAncestor);  // Push a subtree right of its left siblings' subtrees
+        size_t subtreeAncestor(size_t vim, size_t v, size_t defaultAncestor) const;  // The left sibling subtree a contour node belongs to
+        void moveSubtree(size_t wm, size_t wp, double amount);  // Move a subtree right and record the spread for the siblings between
+        void executeShifts(size_t v);  // Apply the recorded shifts to the children of a node
+    };
+
+    // Range [begin, end) of layout indices
+    struct LayoutRange {
+        size_t begin;
+        size_t end;
+    };
+
+    // One level of a layout - its nodes are contiguous and sorted by x
+    struct LayoutLevel {
+        size_t begin;  // First node of the level
+        size_t end;  // One past the last node of the level
+        float y;  // Y of every node of the level
+        float edgeSpan;  // Largest horizontal distance between a node of the level and its parent
+    };
+
+    // Bounds of the node centers of a subtree, its size, and the children of its root
+    struct SubtreeSummary {
+        sf::Vector2f low;  // Smallest x and y of the subtree's node centers
+        sf::Vector2f high;  // Largest x and y of the subtree's node centers
+        size_t count;  // Number of nodes in the subtree
+        size_t firstChild;  // Layout index of the first child (children are contiguous)
+        size_t children;  // Number of children
+    };
+
+    // Level-of-detail selection of one frame (LayoutIndex::select)
+    struct DetailSelection {
+        std::vector<size_t> nodes;  // Nodes drawn one by one
+        std::vector<size_t> aggregates;  // Roots of the subtrees drawn as one shape
+        std::vector<size_t> edges;  // Children of the edges drawn (from a drawn node)
+        std::vector<size_t> pending;  // Work stack of the selection
+
+        void clear() { nodes.clear(); aggregates.clear(); edges.clear(); pending.clear(); }  // Remove everything, keep the capacity
+    };
+
+    // Spatial index over a layout for viewport culling - one row per level.
+    // The levels are found by a binary search on y and the nodes of a level by a binary search on x,
+    // so a query costs O(levels * log n + visible) and does not grow with the nodes outside the rectangle.
+    // An edge is found through its child: its x range is within edgeSpan of the child's x.
+    // The index also keeps a summary of every subtree for level-of-detail drawing of zoomed out views.
+    class LayoutIndex {
+    public:
+        template <typename Handle>
+        void build(const TreeLayout<Handle>& layout);  // Index a layout, O(n)
+
+        // Nodes whose center is within 'margin' of the rectangle, and the children of the edges that may cross it
+        template <typename Handle>
+        void query(const TreeLayout<Handle>& layout, const sf::FloatRect& rect, float margin, std::vector<LayoutRange>& nodes, std::vector<LayoutRange>& edges) const;
+
+        // Like query, but a subtree smaller than 'minExtent' is selected as one aggregate instead of its nodes
+        // Walks down from the root and stops at subtrees outside the rectangle and at aggregates - O(selected)
+        template <typename Handle>
+        void select(const TreeLayout<Handle>& layout, const sf::FloatRect& rect, float margin, float minExtent, DetailSelection& selection) const;
+
+        const std::vector<LayoutLevel>& levels() const;  // Rows of the index
+        const std::vector<SubtreeSummary>& subtrees() const;  // Summary of the subtree of every node, layout order
+        void clear();  // Remove every row
+
+    private:
+        std::vector<LayoutLevel> rows;  // Levels from the root down
+        std::vector<SubtreeSummary> summaries;  // Subtree of every node
+
+        template <typename Handle>
+        static size_t searchX(const TreeLayout<Handle>& layout, size_t begin, size_t end, float x, bool after);  // First node of [begin, end) right of x (or at x if !after)
+    };
+
+    // Part of the world visible through a view (rotation is not used by the viewer)
+    inline sf::FloatRect viewRect(const sf::View& view)
+    {
+        return sf::FloatRect(view.getCenter() - view.getSize() / 2.0f, view.getSize());
+    }
+
+    // Compute the layout of a tree for a render target of the given size
+    // x comes from the tidy layout (NodeSpacing per unit), y is the depth (LevelSpacing per level);
+    // the root is in the middle at the top of the target
+    template <typename View>
+    void layoutTree(const View& view, sf::Vector2u area, TreeLayout<typename View::Handle>& layout)
+    {
+        typedef typename View::Handle Handle;
+        const size_t K = View::arity;
+        layout.clear();
+        if (!view.valid(view.root())) return;
+
+        // Step 1: List the nodes in BFS order - the output arrays are the queue
+        std::vector<size_t> parents(1, NoParent);
+        std::vector<size_t> firstChildren;
+        std::vector<size_t> childCounts;
+        std::vector<size_t> depths(1, 0);
+        layout.handles.push_back(view.root());
+        for (size_t i = 0; i < layout.handles.size(); ++i) {
+            Handle node = layout.handles[i];
+            size_t count = 0;
+            firstChildren.push_back(layout.handles.size());
+            for (size_t c = 0; c < K; ++c) {
+                Handle child = view.child(node, c);
+                if (view.valid(child)) {
+                    layout.handles.push_back(child);
+                    parents.push_back(i);
+                    depths.push_back(depths[i] + 1);
+                    count++;
+                }
+            }
+            childCounts.push_back(count);
+        }
+
+        // Step 2: Tidy x coordinates
+        std::vector<double> x;
+        TidyLayout tidy;
+        tidy.compute(parents, firstChildren, childCounts, x);
+
+        // Step 3: Scale to the target - the root in the middle at the top
+        layout.nodes.resize(layout.handles.size());
+        float left = area.x / 2.0f - static_cast<float>(x[0]) * NodeSpacing;
+        for (size_t i = 0; i < layout.nodes.size(); ++i) {
+            layout.nodes[i].position = sf::Vector2f(left + static_cast<float>(x[i]) * NodeSpacing, RootTop + depths[i] * LevelSpacing);
+            layout.nodes[i].parent = parents[i];
+        }
+    }
+
+
+    // ********** Implementations **********
+
+
+    // Compute the x coordinates
+    /*
+        Step 1: First walk, bottom-up (reverse BFS order) - every node places its children left to right next to their
+                left siblings, pushes each child subtree clear of the subtrees on its left, and centers itself above them
+        Step 2: Second walk, top-down (BFS order) - add the accumulated subtree shifts to the preliminary positions
+    */
+    inline void TidyLayout::compute(const std::vector<size_t>& parents, const std::vector<size_t>& firstChildren, const std::vector<size_t>& childCounts, std::vector<double>& x)
+    {
+        size_t n = parents.size();
+        parent = &parents;
+        firstChild = &firstChildren;
+        childCount = &childCounts;
+        number.assign(n, 0);
+        thread.assign(n, NoParent);
+        ancestor.resize(n);
+        prelim.assign(n, 0);
+        mod.assign(n, 0);
+        change.assign(n, 0);
+        shift.assign(n, 0);
+        middle.assign(n, 0);
+        for (size_t v = 0; v < n; ++v) {
+            ancestor[v] = v;
+            for (size_t c = 0; c < childCounts[v]; ++c) {
+                number[firstChildren[v] + c] = c;
+            }
+        }
+
+        // Step 1: Every child is laid out before its parent
+        for (size_t v = n; v-- > 0;) {
+            size_t count = childCounts[v];
+            if (count == 0) continue;
+            size_t defaultAncestor = firstChildren[v];
+            for (size_t c = 0; c < count; ++c) {
+                size_t w = firstChildren[v] + c;
+                place(w);
+                defaultAncestor = apportion(w, defaultAncestor);
+            }
+            executeShifts(v);
+            middle[v] = (prelim[firstChildren[v]] + prelim[firstChildren[v] + count - 1]) / 2;
+        }
+        place(0);
+
+        // Step 2: A node's x is its preliminary x plus the mods of its ancestors
+        x.assign(n, 0);
+        std::vector<double> modSum(n, 0);
+        for (size_t v = 0; v < n; ++v) {
+            x[v] = prelim[v] + modSum[v];
+            for (size_t c = 0; c < childCounts[v]; ++c) {
+                modSum[firstChildren[v] + c] = modSum[v] + mod[v];
+            }
+        }
+    }
+
+    // The left contour continues with the first child, or the thread at the bottom of a subtree
+    inline size_t TidyLayout::nextLeft(size_t v) const
+    {
+        return (*childCount)[v] > 0 ? (*firstChild)[v] : thread[v];
+    }
+
+    // The right contour continues with the last child, or the thread at the bottom of a subtree
+    inline size_t TidyLayout::nextRight(size_t v) const
+    {
+        return (*childCount)[v] > 0 ? (*firstChild)[v] + (*childCount)[v] - 1 : thread[v];
+    }
+
+    // Check if the node has a left sibling
+    inline bool TidyLayout::hasLeftSibling(size_t v) const
+    {
+        return number[v] > 0;
+    }
+
+    // Place a node one unit right of its left sibling - a parent keeps the offset to its children in mod
+    inline void TidyLayout::place(size_t v)
+    {
+        bool leaf = (*childCount)[v] == 0;
+        if (hasLeftSibling(v)) {
+            prelim[v] = prelim[v - 1] + 1;
+            if (!leaf) {
+                mod[v] = prelim[v] - middle[v];
+            }
+        } else {
+            prelim[v] = leaf ? 0 : middle[v];
+        }
+    }
+
+    // Walk down the inside contours of the subtree of v and of the subtrees left of it, level by level,
+    // and move the subtree of v right wherever they are closer than one unit
+    inline size_t TidyLayout::apportion(size_t v, size_t defaultAncestor)
+    {
+        if (!hasLeftSibling(v)) return defaultAncestor;
+
+        size_t vip = v;  // inside right contour (left side of v's subtree)
+        size_t vop = v;  // outside right contour (right side of v's subtree)
+        size_t vim = v - 1;  // inside left contour (right side of the left sibling's subtree)
+        size_t vom = (*firstChild)[(*parent)[v]];  // outside left contour (left side of the leftmost sibling's subtree)
+        double sip = mod[vip];
+        double sop = mod[vop];
+        double sim = mod[vim];
+        double som = mod[vom];
+
+        while (nextRight(vim) != NoParent && nextLeft(vip) != NoParent) {
+            vim = nextRight(vim);
+            vip = nextLeft(vip);
+            vom = nextLeft(vom);
+            vop = nextRight(vop);
+            ancestor[vop] = v;
+            double distance = (prelim[vim] + sim) - (prelim[vip] + sip) + 1;
+            if (distance > 0) {
+                moveSubtree(subtreeAncestor(vim, v, defaultAncestor), v, distance);
+                sip += distance;
+                sop += distance;
+            }
+            sim += mod[vim];
+            sip += mod[vip];
+            som += mod[vom];
+            sop += mod[vop];
+        }
+
+        // The deeper contour continues through a thread
+        if (nextRight(vim) != NoParent && nextRight(vop) == NoParent) {
+            thread[vop] = nextRight(vim);
+            mod[vop] += sim - sop;
+        }
+        if (nextLeft(vip) != NoParent && nextLeft(vom) == NoParent) {
+            thread[vom] = nextLeft(vip);
+            mod[vom] += sip - som;
+            defaultAncestor = v;
+        }
+        return defaultAncestor;
+    }
+
+    // The sibling of v whose subtree holds the contour node vim
+    inline size_t TidyLayout::subtreeAncestor(size_t vim, size_t v, size_t defaultAncestor) const
+    {
+        size_t candidate = ancestor[vim];
+        return (*parent)[candidate] == (*parent)[v] ? candidate : defaultAncestor;
+    }
+
+    // Move the subtree of wp right and spread the same move over the siblings between wm and wp
+    inline void TidyLayout::moveSubtree(size_t wm, size_t wp, double amount)
+    {
+        double subtrees = static_cast<double>(number[wp] - number[wm]);
+        change[wp] -= amount / subtrees;
+        shift[wp] += amount;
+        change[wm] += amount / subtrees;
+        prelim[wp] += amount;
+        mod[wp] += amount;
+    }
+
+    // Apply the spread shifts to the children of v, from right to left
+    inline void TidyLayout::executeShifts(size_t v)
+    {
+        double totalShift = 0;
+        double totalChange = 0;
+        for (size_t c = (*childCount)[v]; c-- > 0;) {
+            size_t w = (*firstChild)[v] + c;
+            prelim[w] += totalShift;
+            mod[w] += totalShift;
+            totalChange += change[w];
+            totalShift += shift[w] + totalChange;
+        }
+    }
+
+    // Index a layout
+    /*
+        Step 1: Split the layout into levels, record the widest edge into every level and the children of every node
+        Step 2: Summarize the subtrees bottom-up - every node adds its bounds and count to its parent (reverse BFS order)
+    */
+    template <typename Handle>
+    void LayoutIndex::build(const TreeLayout<Handle>& layout)
+    {
+        rows.clear();
+        summaries.resize(layout.size());
+
+        // Step 1: Levels and children
+        for (size_t i = 0; i < layout.size(); ++i) {
+            const LayoutNode& node = layout.nodes[i];
+            summaries[i] = SubtreeSummary{node.position, node.position, 1, 0, 0};
+            if (rows.empty() || node.position.y != rows.back().y) {
+                rows.push_back(LayoutLevel{i, i, node.position.y, 0});
+            }
+            LayoutLevel& level = rows.back();
+            level.end = i + 1;
+            if (node.parent != NoParent) {
+                level.edgeSpan = std::max(level.edgeSpan, std::abs(node.position.x - layout.nodes[node.parent].position.x));
+                SubtreeSummary& parent = summaries[node.parent];
+                if (parent.children++ == 0) {
+                    parent.firstChild = i;
+                }
+            }
+        }
+
+        // Step 2: Subtree bounds and counts
+        for (size_t i = layout.size(); i-- > 1;) {
+            const SubtreeSummary& child = summaries[i];
+            SubtreeSummary& parent = summaries[layout.nodes[i].parent];
+            parent.low.x = std::min(parent.low.x, child.low.x);
+            parent.low.y = std::min(parent.low.y, child.low.y);
+            parent.high.x = std::max(parent.high.x, child.high.x);
+            parent.high.y = std::max(parent.high.y, child.high.y);
+            parent.count += child.count;
+        }
+    }
+
+    // Find the visible ranges
+    /*
+        Step 1: Nodes - for every level within 'margin' of the rectangle's rows, the nodes within 'margin' of its columns
+        Step 2: Edges - for every level whose edges cross the rectangle's rows (the parent level is above the bottom
+                and the level is below the top), the children within edgeSpan of its columns
+    */
+    template <typename Handle>
+    void LayoutIndex::query(const TreeLayout<Handle>& layout, const sf::FloatRect& rect, float margin, std::vector<LayoutRange>& nodes, std::vector<LayoutRange>& edges) const
+    {
+        nodes.clear();
+        edges.clear();
+        float left = rect.left;
+        float right = rect.left + rect.width;
+        float top = rect.top;
+        float bottom = rect.top + rect.height;
+
+        // First level at or below the top of the rectangle (minus the margin)
+        size_t first = std::lower_bound(rows.begin(), rows.end(), top - margin,
+                                        [](const LayoutLevel& level, float y) { return level.y < y; }) - rows.begin();
+
+        // Step 1: Nodes
+        for (size_t l = first; l < rows.size() && rows[l].y <= bottom + margin; ++l) {
+            size_t begin = searchX(layout, rows[l].begin, rows[l].end, left - margin, false);
+            size_t end = searchX(layout, begin, rows[l].end, right + margin, true);
+            if (begin < end) nodes.push_back(LayoutRange{begin, end});
+        }
+
+        // Step 2: Edges - the edges into level l span the rows between level l - 1 and level l
+        size_t firstEdge = std::lower_bound(rows.begin(), rows.end(), top,
+                                            [](const LayoutLevel& level, float y) { return level.y < y; }) - rows.begin();
+        for (size_t l = std::max<size_t>(firstEdge, 1); l < rows.size() && rows[l - 1].y <= bottom; ++l) {
+            float span = rows[l].edgeSpan;
+            size_t begin = searchX(layout, rows[l].begin, rows[l].end, left - span, false);
+            size_t end = searchX(layout, begin, rows[l].end, right + span, true);
+            if (begin < end) edges.push_back(LayoutRange{begin, end});
+        }
+    }
+
+    // Select the nodes and aggregates of a frame
+    // A subtree is skipped when its bounds (grown by 'margin') miss the rectangle, and becomes an aggregate
+    // when it has children and its bounds are smaller than 'minExtent' both ways. Otherwise its root is drawn
+    // (if it is within 'margin' of the rectangle) with the edges to its children that cross the rectangle.
+    template <typename Handle>
+    void LayoutIndex::select(const TreeLayout<Handle>& layout, const sf::FloatRect& rect, float margin, float minExtent, DetailSelection& selection) const
+    {
+        selection.clear();
+        if (summaries.empty()) return;
+        float left = rect.left;
+        float right = rect.left + rect.width;
+        float top = rect.top;
+        float bottom = rect.top + rect.height;
+
+        selection.pending.push_back(0);
+        while (!selection.pending.empty()) {
+            size_t v = selection.pending.back();
+            selection.pending.pop_back();
+            const SubtreeSummary& subtree = summaries[v];
+            if (subtree.high.x + margin < left || subtree.low.x - margin > right || subtree.high.y + margin < top || subtree.low.y - margin > bottom) {
+                continue;  // nothing of the subtree is visible
+            }
+            if (subtree.children > 0 && subtree.high.x - subtree.low.x + 2 * margin < minExtent && subtree.high.y - subtree.low.y + 2 * margin < minExtent) {
+                selection.aggregates.push_back(v);
+                continue;
+            }
+
+            sf::Vector2f position = layout.nodes[v].position;
+            if (position.x + margin >= left && position.x - margin <= right && position.y + margin >= top && position.y - margin <= bottom) {
+                selection.nodes.push_back(v);
+            }
+            for (size_t c = subtree.firstChild + subtree.children; c-- > subtree.firstChild;) {
+                sf::Vector2f child = layout.nodes[c].position;
+                if (std::max(position.x, child.x) >= left && std::min(position.x, child.x) <= right && child.y >= top && position.y <= bottom) {
+                    selection.edges.push_back(c);
+                }
+                selection.pending.push_back(c);
+            }
+        }
+    }
+
+    // Get the rows of the index
+    inline const std::vector<LayoutLevel>& LayoutIndex::levels() const
+    {
+        return rows;
+    }
+
+    // Get the subtree summaries
+    inline const std::vector<SubtreeSummary>& LayoutIndex::subtrees() const
+    {
+        return summaries;
+    }
+
+    // Remove every row and summary
+    inline void LayoutIndex::clear()
+    {
+        rows.clear();
+        summaries.clear();
+    }
+
+    // Binary search on x within one level - 'after' skips the nodes at x too
+    template <typename Handle>
+    size_t LayoutIndex::searchX(const TreeLayout<Handle>& layout, size_t begin, size_t end, float x, bool after)
+    {
+        while (begin < end) {
+            size_t middle = begin + (end - begin) / 2;
+            float mx = layout.nodes[middle].position.x;
+            if (mx < x || (after && mx == x)) {
+                begin = middle + 1;
+            } else {
+                end = middle;
+            }
+        }
+        return begin;
+    }
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef TREE_RASTER_HPP
+#define TREE_RASTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "RasterImage.hpp"
+#include "TreeLayout.hpp"
+#include "TreeDrawing.hpp"
+#include "Parallel.hpp"
+
+namespace ariel {
+
+    // ******Headless export******
+    // The layout of the viewer rasterized on the CPU into a RasterImage - for batch jobs without a display or GPU.
+    // The image is split into tiles that the worker threads take one at a time; each tile asks the LayoutIndex
+    // for the nodes and edges it touches and draws them clipped to itself, so no two threads write the same pixel.
+
+    const int RasterTile = 64;  // Side of a tile in pixels
+    const RasterColor RasterNode = {0, 0, 255, 255};  // sf::Color::Blue
+    const RasterColor RasterLine = {255, 255, 255, 255};  // sf::Color::White
+    const RasterColor RasterText = {255, 255, 255, 255};
+
+    // Rasterize the part 'world' of a laid out tree into the image, the same circles, edges, arrowheads and labels
+    // as TreeRenderer (labels in the built-in font, hidden below LabelPixels)
+    template <typename View>
+    void rasterizeLayout(const TreeLayout<typename View::Handle>& layout, const LayoutIndex& index, const View& view, RasterImage& image, const sf::FloatRect& world, unsigned threads = 0)
+    {
+        if (image.width() == 0 || image.height() == 0 || world.width <= 0 || world.height <= 0) return;
+        float sx = image.width() / world.width;  // Pixels per world unit
+        float sy = image.height() / world.height;
+        float radius = std::max(NodeRadius * sx, 0.5f);
+        bool labels = LabelSize * sx >= LabelPixels;
+        int textScale = std::max(1, static_cast<int>(LabelSize * sx / 10 + 0.5f));  // sf::Text digits are about half the character size
+        const float arrowSize = 10.0f;
+
+        // Nodes whose circle or label may reach into a tile
+        float margin = std::max(NodeRadius, 0.5f / sx);
+        if (labels) {
+            margin += RasterImage::text_width(std::string(16, '0'), textScale) / sx;
+        }
+
+        int columns = (static_cast<int>(image.width()) + RasterTile - 1) / RasterTile;
+        int rows = (static_cast<int>(image.height()) + RasterTile - 1) / RasterTile;
+        size_t tiles = static_cast<size_t>(columns) * rows;
+        std::atomic<size_t> next(0);
+        unsigned workers = static_cast<unsigned>(std::min<size_t>(worker_count(threads), tiles));
+
+        parallel_for(0, workers, workers, [&](size_t, size_t) {
+            std::vector<LayoutRange> nodes, edges;
+            for (size_t tile = next++; tile < tiles; tile = next++) {
+                PixelRect clip;
+                clip.left = static_cast<int>(tile % columns) * RasterTile;
+                clip.top = static_cast<int>(tile / columns) * RasterTile;
+                clip.right = clip.left + RasterTile;
+                clip.bottom = clip.top + RasterTile;
+
+                // The tile in world units, grown by the arrowheads that stick out of the edge bounds
+                sf::FloatRect area(world.left + clip.left / sx - arrowSize, world.top + clip.top / sy - arrowSize,
+                                   RasterTile / sx + 2 * arrowSize, RasterTile / sy + 2 * arrowSize);
+                index.query(layout, area, margin, nodes, edges);
+
+                // Circles, then edges and arrowheads, then labels - the order of drawGeometry
+                for (const LayoutRange& range : nodes) {
+                    for (size_t i = range.begin; i < range.end; ++i) {
+                        sf::Vector2f p = layout.nodes[i].position;
+                        image.fill_circle((p.x - world.left) * sx, (p.y - world.top) * sy, radius, RasterNode, clip);
+                    }
+                }
+                for (const LayoutRange& range : edges) {
+                    for (size_t i = range.begin; i < range.end; ++i) {
+                        sf::Vector2f end = layout.nodes[i].position;
+                        sf::Vector2f start = layout.nodes[layout.nodes[i].parent].position;
+                        sf::Vector2f a((start.x - world.left) * sx, (start.y - world.top) * sy);
+                        sf::Vector2f b((end.x - world.left) * sx, (end.y - world.top) * sy);
+                        image.draw_line(a.x, a.y, b.x, b.y, RasterLine, clip);
+
+                        sf::Vector2f direction = end - start;
+                        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+                        if (length == 0) continue;
+                        direction /= length;
+                        sf::Vector2f side(-direction.y, direction.x);
+                        sf::Vector2f head1 = end - direction * arrowSize + side * arrowSize * 0.5f;
+                        sf::Vector2f head2 = end - direction * arrowSize - side * arrowSize * 0.5f;
+                        image.draw_line(b.x, b.y, (head1.x - world.left) * sx, (head1.y - world.top) * sy, RasterLine, clip);
+                        image.draw_line(b.x, b.y, (head2.x - world.left) * sx, (head2.y - world.top) * sy, RasterLine, clip);
+                    }
+                }
+                if (labels) {
+                    std::ostringstream oss;
+                    for (const LayoutRange& range : nodes) {
+                        for (size_t i = range.begin; i < range.end; ++i) {
+                            sf::Vector2f p = layout.nodes[i].position;
+                            oss.str(std::string());
+                            oss << view.key(layout.handles[i]);
+                            image.draw_text(oss.str(), (p.x - NodeRadius / 2 - world.left) * sx, (p.y - NodeRadius / 2 - world.top) * sy, textScale, RasterText, clip);
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    // Rasterize a tree into the image - the layout of a target of the image size, and the part 'world' of it
+    template <typename View>
+    void rasterizeTree(const View& view, RasterImage& image, const sf::FloatRect& world, unsigned threads = 0)
+    {
+        TreeLayout<typename View::Handle> layout;
+        layoutTree(view, sf::Vector2u(image.width(), image.height()), layout);
+        LayoutIndex index;
+        index.build(layout);
+        rasterizeLayout(layout, index, view, image, world, threads);
+    }
+
+    // Rasterize a whole tree into the image - the tree is scaled to fit and centered
+    template <typename View>
+    void rasterizeTree(const View& view, RasterImage& image, unsigned threads = 0)
+    {
+        TreeLayout<typename View::Handle> layout;
+        layoutTree(view, sf::Vector2u(image.width(), image.height()), layout);
+        if (layout.size() == 0 || image.width() == 0 || image.height() == 0) return;
+        LayoutIndex index;
+        index.build(layout);
+
+        // The bounds of every circle, widened to the aspect ratio of the image
+        const SubtreeSummary& whole = index.subtrees()[0];
+        sf::Vector2f low = whole.low - sf::Vector2f(NodeRadius, NodeRadius);
+        sf::Vector2f size = whole.high - whole.low + sf::Vector2f(2 * NodeRadius, 2 * NodeRadius);
+        float aspect = static_cast<float>(image.width()) / image.height();
+        if (size.x / size.y < aspect) {
+            low.x -= (size.y * aspect - size.x) / 2;
+            size.x = size.y * aspect;
+        } else {
+            low.y -= (size.x / aspect - size.y) / 2;
+            size.y = size.x / aspect;
+        }
+        rasterizeLayout(layout, index, view, image, sf::FloatRect(low, size), threads);
+    }
+
+}
+
+#endif
@@ -0,0 +1,814 @@
+#include "Tree.hpp"
+#include "Complex.hpp"
+#include "KaryHeap.hpp"
+#include "ArrayHeap.hpp"
+#include "MeldableHeap.hpp"
+#include "ComplexArray.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <string>
+
+using namespace ariel;
+
+// Measure the wall time of a callable in milliseconds
+template <typename Function>
+double measureMs(Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Generate 'count' random integer keys with a fixed seed, so every run uses the same input
+std::vector<int> randomKeys(size_t count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 1 << 30);
+    std::vector<int> keys(count);
+    for (int& key : keys) {
+        key = distribution(generator);
+    }
+    return keys;
+}
+
+// Fill an empty tree with the given keys, level by level (complete K-ary shape)
+template <typename T, size_t K>
+void buildTree(Tree<T, K>& tree, const std::vector<T>& keys) {
+    if (keys.empty()) return;
+    tree.add_root(keys[0]);
+
+    std::queue<typename Tree<T, K>::Node*> parents;
+    parents.push(tree.get_root());
+    size_t next = 1;
+    while (next < keys.size()) {
+        typename Tree<T, K>::Node* parent = parents.front();
+        parents.pop();
+        for (size_t i = 0; i < K && next < keys.size(); ++i) {
+            tree.add_sub_node(parent, keys[next++]);
+            parents.push(parent->children[i]);
+        }
+    }
+}
+
+// Heapify a tree with arity K and pop every key from a K-ary heap array
+template <size_t K>
+void benchHeapArity(const std::vector<int>& keys) {
+    Tree<int, K> tree;
+    buildTree(tree, keys);
+    double heapifyMs = measureMs([&]() { tree.myHeap(); });
+
+    std::vector<int> heap(keys);
+    make_kary_heap<K>(heap.begin(), heap.end(), std::greater<int>());
+    double popMs = measureMs([&]() {
+        for (auto last = heap.end(); last != heap.begin(); --last) {
+            pop_kary_heap<K>(heap.begin(), last, std::greater<int>());
+        }
+    });
+
+    std::printf("  K=%zu  myHeap %9.2f ms  (%6.1f Mkeys/s)   pop-all %9.2f ms  (%6.1f Mpops/s)\n",
+                K, heapifyMs, keys.size() / heapifyMs / 1000.0, popMs, keys.size() / popMs / 1000.0);
+}
+
+// Generate 'count' random Complex keys with a fixed seed
+std::vector<Complex> randomComplexKeys(size_t count) {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> distribution(-1000.0, 1000.0);
+    std::vector<Complex> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        double re = distribution(generator);
+        keys.push_back(Complex(re, distribution(generator)));
+    }
+    return keys;
+}
+
+// Magnitude order through std::hypot, as Complex::operator< compared before
+struct HypotLess {
+    bool operator()(const Complex& a, const Complex& b) const {
+        return std::hypot(a.re(), a.im()) < std::hypot(b.re(), b.im());
+    }
+};
+struct HypotGreater {
+    bool operator()(const Complex& a, const Complex& b) const {
+        return HypotLess()(b, a);
+    }
+};
+
+// Sort and heapify Complex keys: hypot comparison, squared-magnitude operator<, projected norm and NormedComplex
+void benchComplexOrdering(const std::vector<Complex>& keys) {
+    std::vector<Complex> sorted(keys);
+    double sortHypotMs = measureMs([&]() { std::sort(sorted.begin(), sorted.end(), HypotLess()); });
+    sorted = keys;
+    double sortNormMs = measureMs([&]() { std::sort(sorted.begin(), sorted.end()); });
+    std::vector<NormedComplex> normed(keys.begin(), keys.end());
+    double sortCachedMs = measureMs([&]() { std::sort(normed.begin(), normed.end()); });
+    std::printf("  sort     hypot %8.2f ms   operator< %8.2f ms   NormedComplex %8.2f ms\n",
+                sortHypotMs, sortNormMs, sortCachedMs);
+
+    Tree<Complex> byHypot;
+    buildTree(byHypot, keys);
+    double heapHypotMs = measureMs([&]() { byHypot.myHeap(HypotGreater()); });
+
+    Tree<Complex> byOperator;
+    buildTree(byOperator, keys);
+    double heapNormMs = measureMs([&]() { byOperator.myHeap(); });
+
+    Tree<Complex> byProjection;
+    buildTree(byProjection, keys);
+    double heapProjectionMs = measureMs([&]() {
+        byProjection.myHeap(std::greater<double>(), [](const Complex& c) { return c.norm(); });
+    });
+
+    Tree<NormedComplex> byCached;
+    buildTree(byCached, std::vector<NormedComplex>(keys.begin(), keys.end()));
+    double heapCachedMs = measureMs([&]() { byCached.myHeap(); });
+    std::printf("  myHeap   hypot %8.2f ms   operator< %8.2f ms   projected norm() %8.2f ms   NormedComplex %8.2f ms\n",
+                heapHypotMs, heapNormMs, heapProjectionMs, heapCachedMs);
+}
+
+// Use the tree as a live priority queue - push every key, then pop them all
+void benchHeapOperations(const std::vector<int>& keys) {
+    Tree<int> tree;
+    double pushMs = measureMs([&]() {
+        for (int key : keys) {
+            tree.push(key);
+        }
+    });
+    double popMs = measureMs([&]() {
+        while (tree.size() > 0) {
+            tree.pop_min();
+        }
+    });
+    std::printf("  push %9.2f ms  (%6.1f Mops/s)   pop_min %9.2f ms  (%6.1f Mops/s)\n",
+                pushMs, keys.size() / pushMs / 1000.0, popMs, keys.size() / popMs / 1000.0);
+}
+
+// Heapify the same tree serially and on 1, 2, 4 ... hardware threads
+void benchParallelHeap(const std::vector<int>& keys) {
+    double serialMs = 0;
+    {
+        Tree<int> serial;
+        buildTree(serial, keys);
+        serialMs = measureMs([&]() { serial.myHeap(); });
+    }
+    std::printf("  myHeap            %9.2f ms\n", serialMs);
+
+    for (unsigned threads = 1; threads <= worker_count(); threads *= 2) {
+        Tree<int> tree;
+        buildTree(tree, keys);
+        double parallelMs = measureMs([&]() { tree.myHeapParallel(std::greater<int>(), threads); });
+        std::printf("  myHeapParallel %2u %9.2f ms  (x%.2f)\n", threads, parallelMs, serialMs / parallelMs);
+    }
+}
+
+// Compare the pointer based tree heap with the implicit array heap - memory and push / pop throughput
+void benchArrayHeap(const std::vector<int>& keys) {
+    Tree<int> tree;
+    double treePushMs = measureMs([&]() {
+        for (int key : keys) {
+            tree.push(key);
+        }
+    });
+    double treePopMs = measureMs([&]() {
+        while (tree.size() > 0) {
+            tree.pop_min();
+        }
+    });
+
+    ArrayHeap<int> heap;
+    double arrayPushMs = measureMs([&]() {
+        for (int key : keys) {
+            heap.push(key);
+        }
+    });
+    size_t arrayBytes = heap.keys().capacity() * sizeof(int);
+    double arrayPopMs = measureMs([&]() {
+        while (!heap.empty()) {
+            heap.pop_min();
+        }
+    });
+
+    // Every tree node is a separate allocation - assume 16 bytes of allocator overhead per node
+    size_t treeBytes = keys.size() * (sizeof(Tree<int>::Node) + 16);
+    std::printf("  Tree<int>      %8.1f MB   push %8.2f ms   pop_min %8.2f ms\n", treeBytes / 1e6, treePushMs, treePopMs);
+    std::printf("  ArrayHeap<int> %8.1f MB   push %8.2f ms   pop_min %8.2f ms\n", arrayBytes / 1e6, arrayPushMs, arrayPopMs);
+}
+
+// Select the k smallest keys - bounded heap streaming vs heapify and pop
+void benchTopK(const std::vector<int>& keys, size_t k) {
+    Tree<int> tree;
+    buildTree(tree, keys);
+
+    std::vector<int> selected;
+    double topKMs = measureMs([&]() { selected = tree.top_k(k); });
+    double parallelMs = measureMs([&]() { selected = tree.top_k_parallel(k); });
+    double heapMs = measureMs([&]() {
+        tree.myHeap();
+        selected.clear();
+        for (size_t i = 0; i < k; ++i) {
+            selected.push_back(tree.pop_min());
+        }
+    });
+    std::printf("  k=%zu  top_k %8.2f ms   top_k_parallel %8.2f ms   myHeap + pop_min %8.2f ms\n",
+                k, topKMs, parallelMs, heapMs);
+}
+
+// Merge 'rounds' small priority queues into one big queue - meld vs copy both into one tree and heapify again
+template <MeldDiscipline D>
+double benchMeld(const std::vector<int>& keys, size_t rounds) {
+    size_t chunk = keys.size() / rounds;
+    MeldableHeap<int, D> merged;
+    double ms = measureMs([&]() {
+        for (size_t r = 0; r < rounds; ++r) {
+            MeldableHeap<int, D> part;
+            for (size_t i = r * chunk; i < (r + 1) * chunk; ++i) {
+                part.push(keys[i]);
+            }
+            merged.meld(part);
+            merged.pop_min();
+        }
+    });
+    return ms;
+}
+
+void benchMeldableHeaps(const std::vector<int>& keys, size_t rounds) {
+    size_t chunk = keys.size() / rounds;
+    double rebuildMs = measureMs([&]() {
+        std::vector<int> merged;
+        for (size_t r = 0; r < rounds; ++r) {
+            // Copy the merged queue and the new queue into one tree, heapify it again and pop
+            merged.insert(merged.end(), keys.begin() + r * chunk, keys.begin() + (r + 1) * chunk);
+            Tree<int> tree;
+            buildTree(tree, merged);
+            tree.myHeap();
+            tree.pop_min();
+            merged.clear();
+            for (auto it = tree.begin_bfs(); it != tree.end_bfs(); ++it) {
+                merged.push_back(*it);
+            }
+        }
+    });
+    std::printf("  rebuild + myHeap %9.2f ms\n", rebuildMs);
+    std::printf("  skew heap        %9.2f ms\n", benchMeld<MeldDiscipline::Skew>(keys, rounds));
+    std::printf("  pairing heap     %9.2f ms\n", benchMeld<MeldDiscipline::Pairing>(keys, rounds));
+}
+
+// Out-of-line addition, as Complex::operator+= was before it moved into the header
+__attribute__((noinline)) void addOutOfLine(Complex& total, const Complex& value) {
+    total += value;
+}
+
+// Sum every key of a Tree<Complex> - through the tree iterator and over the gathered keys,
+// with the inline operator+= and with an opaque out-of-line call
+void benchComplexSum(const std::vector<Complex>& keys) {
+    Tree<Complex> tree;
+    buildTree(tree, keys);
+
+    Complex treeTotal;
+    double treeMs = measureMs([&]() {
+        for (auto it = tree.begin_bfs(); it != tree.end_bfs(); ++it) {
+            treeTotal += *it;
+        }
+    });
+
+    Complex inlineTotal;
+    double inlineMs = measureMs([&]() {
+        for (const Complex& key : keys) {
+            inlineTotal += key;
+        }
+    });
+
+    Complex callTotal;
+    double callMs = measureMs([&]() {
+        for (const Complex& key : keys) {
+            addOutOfLine(callTotal, key);
+        }
+    });
+
+    std::printf("  sum over BFS %8.2f ms   gathered inline %8.2f ms   gathered out-of-line call %8.2f ms   (%g %g %g)\n",
+                treeMs, inlineMs, callMs, treeTotal.re(), inlineTotal.re(), callTotal.re());
+}
+
+// Batch Complex kernels: one Complex object at a time (array of structures) vs ComplexArray (structure of arrays)
+void benchComplexArray(const std::vector<Complex>& keys) {
+    Tree<Complex> tree;
+    buildTree(tree, keys);
+    std::vector<Complex> gathered;
+    double bfsMs = measureMs([&]() {
+        for (auto it = tree.begin_bfs(); it != tree.end_bfs(); ++it) {
+            gathered.push_back(*it);
+        }
+    });
+    ComplexArray preOrder;
+    double gatherMs = measureMs([&]() { preOrder = ComplexArray::gather(tree); });
+    std::printf("  gather   BFS iterator %8.2f ms   ComplexArray::gather %8.2f ms\n", bfsMs, gatherMs);
+
+    // Both layouts hold the keys in the same (BFS) order, the outputs are allocated before timing
+    ComplexArray a(gathered.begin(), gathered.end());
+    std::vector<Complex> other(gathered.rbegin(), gathered.rend());
+    ComplexArray b(other.begin(), other.end());
+    std::vector<Complex> scalarOut(gathered.size());
+    ComplexArray out(gathered.size());
+    std::vector<double> norms(gathered.size());
+
+    double addScalarMs = measureMs([&]() {
+        for (size_t i = 0; i < gathered.size(); ++i) scalarOut[i] = gathered[i] + other[i];
+    });
+    double addMs = measureMs([&]() { ComplexArray::add(a, b, out); });
+    double mulScalarMs = measureMs([&]() {
+        for (size_t i = 0; i < gathered.size(); ++i) scalarOut[i] = gathered[i] * other[i];
+    });
+    double mulMs = measureMs([&]() { ComplexArray::multiply(a, b, out); });
+    double fmaScalarMs = measureMs([&]() {
+        for (size_t i = 0; i < gathered.size(); ++i) scalarOut[i] += gathered[i] * other[i];
+    });
+    double fmaMs = measureMs([&]() { ComplexArray::multiply_add(a, b, out); });
+    double normScalarMs = measureMs([&]() {
+        for (size_t i = 0; i < gathered.size(); ++i) norms[i] = gathered[i].norm();
+    });
+    double normMs = measureMs([&]() { ComplexArray::norm(a, norms); });
+    size_t scalarMin = 0;
+    double argminScalarMs = measureMs([&]() {
+        scalarMin = std::min_element(gathered.begin(), gathered.end()) - gathered.begin();
+    });
+    size_t arrayMin = 0;
+    double argminMs = measureMs([&]() { arrayMin = ComplexArray::argmin_norm(a); });
+
+    std::printf("  kernels (%s)      Complex loop   ComplexArray\n", ComplexArray::backend());
+    std::printf("  add            %12.2f ms %12.2f ms\n", addScalarMs, addMs);
+    std::printf("  multiply       %12.2f ms %12.2f ms\n", mulScalarMs, mulMs);
+    std::printf("  multiply_add   %12.2f ms %12.2f ms\n", fmaScalarMs, fmaMs);
+    std::printf("  norm           %12.2f ms %12.2f ms\n", normScalarMs, normMs);
+    std::printf("  argmin         %12.2f ms %12.2f ms   (index %zu / %zu, checksum %g)\n",
+                argminScalarMs, argminMs, scalarMin, arrayMin, scalarOut[7].re() + out[7].re() + norms[7]);
+}
+
+// Key memory and throughput of the double (Complex) and float (FloatComplex) instantiations
+template <typename F>
+void benchComplexScalar(const char* name, const std::vector<Complex>& source) {
+    typedef BasicComplex<F> Key;
+    std::vector<Key> keys;
+    keys.reserve(source.size());
+    for (const Complex& key : source) {
+        keys.push_back(Key(key));
+    }
+
+    std::vector<Key> sorted(keys);
+    double sortMs = measureMs([&]() { std::sort(sorted.begin(), sorted.end()); });
+    Key total;
+    double sumMs = measureMs([&]() {
+        for (const Key& key : keys) {
+            total += key * key;
+        }
+    });
+    Tree<Key> tree;
+    buildTree(tree, keys);
+    double heapMs = measureMs([&]() { tree.myHeap(); });
+
+    std::printf("  %-12s key %2zu B  node %2zu B  keys %6.1f MB   sort %8.2f ms   sum of squares %6.2f ms   myHeap %8.2f ms   (%g)\n",
+                name, sizeof(Key), sizeof(typename Tree<Key>::Node), keys.size() * sizeof(Key) / 1e6,
+                sortMs, sumMs, heapMs, static_cast<double>(total.re()));
+}
+
+// Find nodes by key: BFS walk vs the hash index, and the cost of keeping the index during heap operations
+void benchKeyIndex(const std::vector<int>& keys, size_t lookups) {
+    Tree<int> tree;
+    buildTree(tree, keys);
+
+    size_t found = 0;
+    double bfsMs = measureMs([&]() {
+        for (size_t i = 0; i < lookups; ++i) {
+            found += tree.find(keys[(i * 7919) % keys.size()]) != nullptr;
+        }
+    });
+    double buildMs = measureMs([&]() { tree.enable_index(); });
+    double indexMs = measureMs([&]() {
+        for (size_t i = 0; i < lookups; ++i) {
+            found += tree.find(keys[(i * 7919) % keys.size()]) != nullptr;
+        }
+    });
+    Tree<int>::IndexStats stats = tree.index_stats();
+    std::printf("  %zu lookups   BFS %10.2f ms   index %8.3f ms   (index build %.2f ms, %zu entries, %.1f MB, load %.2f, found %zu)\n",
+                lookups, bfsMs, indexMs, buildMs, stats.entries, stats.bytes / 1e6, stats.loadFactor, found);
+
+    Tree<int> plain;
+    buildTree(plain, keys);
+    plain.myHeap();
+    tree.myHeap();
+    double plainMs = measureMs([&]() {
+        for (size_t i = 0; i < keys.size() / 4; ++i) plain.push(keys[i]);
+        for (size_t i = 0; i < keys.size() / 4; ++i) plain.pop_min();
+    });
+    double indexedMs = measureMs([&]() {
+        for (size_t i = 0; i < keys.size() / 4; ++i) tree.push(keys[i]);
+        for (size_t i = 0; i < keys.size() / 4; ++i) tree.pop_min();
+    });
+    std::printf("  push + pop_min   without index %8.2f ms   with index %8.2f ms\n", plainMs, indexedMs);
+}
+
+// Text IO of "a+bi" literals: iostream operators vs the bulk from_chars / to_chars functions
+void benchComplexText(const std::vector<Complex>& keys) {
+    std::ostringstream formatted;
+    double streamWriteMs = measureMs([&]() {
+        for (const Complex& key : keys) {
+            formatted << key << '\n';
+        }
+    });
+    std::string streamText = formatted.str();
+
+    std::string bulkText;
+    double bulkWriteMs = measureMs([&]() { format_complex_buffer(keys.data(), keys.size(), bulkText, 6); });
+    std::string exactText;
+    double exactWriteMs = measureMs([&]() { format_complex_buffer(keys.data(), keys.size(), exactText); });
+
+    std::vector<Complex> streamValues;
+    double streamReadMs = measureMs([&]() {
+        std::istringstream input(exactText);
+        Complex value;
+        while (input >> value) {
+            streamValues.push_back(value);
+        }
+    });
+    ComplexParseResult parsed;
+    double bulkReadMs = measureMs([&]() { parse_complex_buffer(exactText.data(), exactText.size(), parsed); });
+
+    std::printf("  format   operator<< %8.2f ms   format_complex_buffer %8.2f ms (same text: %s)   shortest round trip %8.2f ms\n",
+                streamWriteMs, bulkWriteMs, streamText == bulkText ? "yes" : "no", exactWriteMs);
+    std::printf("  parse    operator>> %8.2f ms   parse_complex_buffer  %8.2f ms (%zu / %zu values, %zu errors, %.1f MB)\n",
+                streamReadMs, bulkReadMs, streamValues.size(), parsed.values.size(), parsed.errors.size(), exactText.size() / 1e6);
+}
+
+// Frame time of Tree::draw into an off-screen texture, and the font loading the draw path used to do per node
+void benchDrawFrame(size_t nodes, int frames) {
+    std::vector<int> keys(nodes);
+    for (size_t i = 0; i < nodes; ++i) keys[i] = static_cast<int>(i);
+    Tree<int> tree;
+    buildTree(tree, keys);
+
+    double loadMs = measureMs([&]() {
+        for (size_t i = 0; i < nodes; ++i) {
+            sf::Font font;
+            font.loadFromFile(FontCache::default_path());
+        }
+    });
+    double cachedMs = measureMs([&]() {
+        for (size_t i = 0; i < nodes; ++i) {
+            FontCache::default_font();
+        }
+    });
+    std::printf("  font per frame   loadFromFile per node %8.2f ms   FontCache per node %8.4f ms\n", loadMs, cachedMs);
+
+    sf::RenderTexture target;
+    if (!target.create(800, 600)) {
+        std::printf("  frame            skipped (no render context)\n");
+        return;
+    }
+    double frameMs = measureMs([&]() {
+        for (int i = 0; i < frames; ++i) {
+            target.clear(sf::Color::Black);
+            tree.draw(target);
+            target.display();
+        }
+    });
+    std::printf("  frame            Tree::draw %8.2f ms per frame\n", frameMs / frames);
+}
+
+// View of a binary heap array for the drawing functions
+struct HeapView {
+    typedef size_t Handle;
+    static const size_t arity = 2;
+    const std::vector<int>* keys;
+
+    Handle root() const { return 0; }
+    bool valid(Handle index) const { return index < keys->size(); }
+    Handle child(Handle index, size_t i) const { return 2 * index + 1 + i; }
+    const int& key(Handle index) const { return (*keys)[index]; }
+};
+
+// Geometry of a large tree: layout, shapes and labels of the first frame, and a frame with the cached layout
+void benchTreeGeometry(size_t nodes) {
+    std::vector<int> keys(nodes);
+    for (size_t i = 0; i < nodes; ++i) keys[i] = static_cast<int>(i);
+    ArrayHeap<int> heap(keys.begin(), keys.end());
+
+    HeapView view = {&heap.keys()};
+    TreeLayout<size_t> layout;
+    TreeGeometry geometry;
+    LabelCache<size_t, int> labels;
+    double layoutMs = measureMs([&]() { layoutTree(view, sf::Vector2u(800, 600), layout); });
+    double shapesMs = measureMs([&]() { buildShapes(layout, geometry); });
+    double firstLabelsMs = measureMs([&]() { buildLabels(layout, view, labels, geometry); });
+    labels.next_frame();
+    double nextLabelsMs = measureMs([&]() { buildLabels(layout, view, labels, geometry); });
+    double glyphsMs = measureMs([&]() { buildGlyphs(geometry); });
+    std::printf("  %zu nodes   layout %6.2f ms   shapes %6.2f ms   labels %6.2f ms   next frame (cached layout and labels) %6.2f ms   glyphs %6.2f ms\n",
+                nodes, layoutMs, shapesMs, firstLabelsMs, nextLabelsMs, glyphsMs);
+    std::printf("  %zu triangle + %zu line + %zu glyph vertices for %zu labels   draw calls: 3 (was ~%zu)\n",
+                geometry.triangles.getVertexCount(), geometry.lines.getVertexCount(), geometry.glyphs.getVertexCount(), geometry.labels.size(), 4 * nodes);
+}
+
+// Headless frames through TreeRenderer::build at full detail, the whole tree in view at one pixel per world unit:
+// the first frame (layout, index, shapes, labels), an unchanged frame (labels), and a moved view (shapes and labels)
+void benchFrameBuild(const std::vector<size_t>& sizes) {
+    for (size_t nodes : sizes) {
+        std::vector<int> keys(nodes);
+        for (size_t i = 0; i < nodes; ++i) keys[i] = static_cast<int>(i);
+        HeapView view = {&keys};
+
+        TreeLayout<size_t> layout;
+        layoutTree(view, sf::Vector2u(0, 0), layout);
+        LayoutIndex index;
+        index.build(layout);
+        const SubtreeSummary& whole = index.subtrees()[0];
+        sf::Vector2u size(static_cast<unsigned>(whole.high.x - whole.low.x + 2 * NodeRadius) + 1,
+                          static_cast<unsigned>(whole.high.y - whole.low.y + 2 * NodeRadius) + 1);
+        sf::View camera(sf::FloatRect(whole.low.x + size.x / 2.0f - NodeRadius, whole.low.y - NodeRadius,
+                                      static_cast<float>(size.x), static_cast<float>(size.y)));
+        layout = TreeLayout<size_t>();
+        index.clear();
+
+        TreeRenderer<HeapView> renderer;
+        double firstMs = measureMs([&]() { renderer.build(size, camera, view); });
+        double sameMs = measureMs([&]() { renderer.build(size, camera, view); });
+        camera.move(1, 0);
+        double movedMs = measureMs([&]() { renderer.build(size, camera, view); });
+        std::printf("  %8zu nodes   first frame %7.2f ms (%5.0f ns/node)   unchanged %6.2f ms (%4.0f ns/node)   moved %6.2f ms (%4.0f ns/node)   %zu labels\n",
+                    nodes, firstMs, firstMs * 1e6 / nodes, sameMs, sameMs * 1e6 / nodes, movedMs, movedMs * 1e6 / nodes,
+                    renderer.geometry().labels.size());
+    }
+}
+
+// Random tree of up to 3 children per node - slot 3*i+c holds the c-th child of node i, or NoParent
+struct RandomTreeView {
+    typedef size_t Handle;
+    static const size_t arity = 3;
+    const std::vector<size_t>* slots;
+
+    Handle root() const { return 0; }
+    bool valid(Handle index) const { return index != NoParent; }
+    Handle child(Handle index, size_t i) const { return (*slots)[3 * index + i]; }
+    size_t key(Handle index) const { return index; }
+};
+
+// Tidy layout time against tree size - a complete binary tree and a random ternary tree of every size
+void benchTidyLayout(const std::vector<size_t>& sizes) {
+    std::mt19937 generator(42);
+    for (size_t nodes : sizes) {
+        std::vector<int> keys(nodes);
+        HeapView complete = {&keys};
+
+        // Attach every node to a random earlier node with a free slot - the depths vary widely
+        std::vector<size_t> slots(3 * nodes, NoParent);
+        std::vector<size_t> open(1, 0);
+        for (size_t node = 1; node < nodes; ++node) {
+            size_t pick = generator() % open.size();
+            size_t parent = open[pick];
+            size_t c = 0;
+            while (slots[3 * parent + c] != NoParent) ++c;
+            slots[3 * parent + c] = node;
+            if (c == 2) {
+                open[pick] = open.back();
+                open.pop_back();
+            }
+            open.push_back(node);
+        }
+        RandomTreeView random = {&slots};
+
+        TreeLayout<size_t> layout;
+        double completeMs = measureMs([&]() { layoutTree(complete, sf::Vector2u(800, 600), layout); });
+        double randomMs = measureMs([&]() { layoutTree(random, sf::Vector2u(800, 600), layout); });
+        std::printf("  %8zu nodes   complete binary %8.2f ms (%5.1f ns/node)   random ternary %8.2f ms (%5.1f ns/node)\n",
+                    nodes, completeMs, completeMs * 1e6 / nodes, randomMs, randomMs * 1e6 / nodes);
+    }
+}
+
+// Per-frame geometry of an 800x600 view over trees of growing size - culled through the LayoutIndex vs every node
+void benchCulledFrame(const std::vector<size_t>& sizes) {
+    for (size_t nodes : sizes) {
+        std::vector<int> keys(nodes);
+        for (size_t i = 0; i < nodes; ++i) keys[i] = static_cast<int>(i);
+        HeapView view = {&keys};
+        TreeLayout<size_t> layout;
+        layoutTree(view, sf::Vector2u(800, 600), layout);
+        LayoutIndex index;
+        double indexMs = measureMs([&]() { index.build(layout); });
+
+        // A view around the middle of the deepest levels - the densest part of the drawing
+        const LayoutLevel& bottom = index.levels().back();
+        sf::Vector2f center = layout.nodes[(bottom.begin + bottom.end) / 2].position;
+        sf::FloatRect rect(center.x - 400, center.y - 300, 800, 600);
+
+        TreeGeometry geometry;
+        LabelCache<size_t, int> labels;
+        std::vector<LayoutRange> visibleNodes, visibleEdges;
+        const int frames = 50;
+        double culledMs = measureMs([&]() {
+            for (int i = 0; i < frames; ++i) {
+                rect.left += 1;  // a pan every frame - the shapes are built again
+                index.query(layout, rect, NodeRadius, visibleNodes, visibleEdges);
+                buildShapes(layout, visibleNodes, visibleEdges, rect, geometry);
+                buildLabels(layout, visibleNodes, view, labels, geometry);
+                labels.next_frame();
+            }
+        }) / frames;
+        size_t drawn = geometry.triangles.getVertexCount() / (3 * CirclePoints);
+        std::printf("  %8zu nodes   index %7.2f ms   culled frame %6.3f ms (%zu nodes)", nodes, indexMs, culledMs, drawn);
+        if (nodes <= 100000) {
+            // 90 triangle vertices per node - a million nodes would take gigabytes
+            double fullMs = measureMs([&]() { buildShapes(layout, geometry); });
+            std::printf("   every node %8.2f ms", fullMs);
+        }
+        std::printf("\n");
+    }
+}
+
+// Per-frame geometry of the whole tree in an 800x600 target - level of detail vs every node in the view
+void benchLevelOfDetail(const std::vector<size_t>& sizes) {
+    for (size_t nodes : sizes) {
+        std::vector<int> keys(nodes);
+        HeapView view = {&keys};
+        TreeLayout<size_t> layout;
+        layoutTree(view, sf::Vector2u(800, 600), layout);
+        LayoutIndex index;
+        double indexMs = measureMs([&]() { index.build(layout); });
+
+        const SubtreeSummary& whole = index.subtrees()[0];
+        sf::FloatRect rect(whole.low.x - NodeRadius, whole.low.y - NodeRadius, whole.high.x - whole.low.x + 2 * NodeRadius, whole.high.y - whole.low.y + 2 * NodeRadius);
+        float pixels = 800 / rect.width;
+
+        TreeGeometry geometry;
+        LabelCache<size_t, int> labels;
+        LabelCache<size_t, size_t> counts;
+        DetailSelection selection;
+        const int frames = 20;
+        double lodMs = measureMs([&]() {
+            for (int i = 0; i < frames; ++i) {
+                index.select(layout, rect, NodeRadius, AggregatePixels / pixels, selection);
+                buildShapes(layout, index.subtrees(), selection, geometry);
+                buildLabels(layout, index.subtrees(), selection, view, labels, counts, pixels, false, geometry);
+                labels.next_frame();
+                counts.next_frame();
+            }
+        }) / frames;
+
+        std::vector<LayoutRange> visibleNodes, visibleEdges;
+        index.query(layout, rect, NodeRadius, visibleNodes, visibleEdges);
+        size_t inView = 0;
+        for (const LayoutRange& range : visibleNodes) inView += range.end - range.begin;
+        std::printf("  %8zu nodes   summaries + rows %7.2f ms   LOD frame %6.3f ms (%zu nodes + %zu aggregates instead of %zu nodes)\n",
+                    nodes, indexMs, lodMs, selection.nodes.size(), selection.aggregates.size(), inView);
+    }
+}
+
+// Headless export of a tree - tile rasterization of the whole tree (scaled to fit) and of a 1:1 region, then PNG / PPM encoding
+void benchRaster(size_t nodes, unsigned width, unsigned height) {
+    std::vector<int> keys(nodes);
+    for (size_t i = 0; i < nodes; ++i) keys[i] = static_cast<int>(i);
+    HeapView view = {&keys};
+    unsigned threads = worker_count();
+
+    RasterImage fitted(width, height);
+    double fitMs = measureMs([&]() { rasterizeTree(view, fitted, threads); });
+    RasterImage region(width, height);
+    double regionMs = measureMs([&]() { rasterizeTree(view, region, sf::FloatRect(0, 0, static_cast<float>(width), static_cast<float>(height)), threads); });
+
+    std::ostringstream png, ppm;
+    double pngMs = measureMs([&]() { fitted.write_png(png); });
+    double ppmMs = measureMs([&]() { fitted.write_ppm(ppm); });
+    std::printf("  %zu nodes, %ux%u, %u threads   whole tree %7.2f ms   1:1 region with labels %7.2f ms\n",
+                nodes, width, height, threads, fitMs, regionMs);
+    std::printf("  encode   PNG %7.2f ms (%zu KB)   PPM %7.2f ms (%zu KB)\n",
+                pngMs, png.str().size() / 1024, ppmMs, ppm.str().size() / 1024);
+}
+
+// Stream buffer that only counts the bytes written to it - the exporters are measured without a disk
+class CountingBuffer : public std::streambuf {
+public:
+    size_t bytes = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override { bytes += count; return count; }
+    int_type overflow(int_type c) override { if (c != traits_type::eof()) bytes++; return c; }
+};
+
+// SVG and DOT export of complete binary trees - SVG from the renderer's layout (the first export computes it,
+// the next one reuses it), DOT from a walk along the parent pointers
+void benchExport(const std::vector<size_t>& sizes) {
+    for (size_t nodes : sizes) {
+        std::vector<int> keys(nodes);
+        for (size_t i = 0; i < nodes; ++i) keys[i] = static_cast<int>(i);
+        Tree<int> tree;
+        buildTree(tree, keys);
+        keys = std::vector<int>();
+
+        CountingBuffer firstBytes, svgBytes, dotBytes;
+        std::ostream first(&firstBytes), svg(&svgBytes), dot(&dotBytes);
+        double firstMs = measureMs([&]() { tree.write_svg(first); });
+        double svgMs = measureMs([&]() { tree.write_svg(svg); });
+        double dotMs = measureMs([&]() { tree.write_dot(dot); });
+        std::printf("  %8zu nodes   SVG with layout %7.1f ms   SVG %7.1f ms (%6.1f MB, %6.1f MB/s)   DOT %7.1f ms (%6.1f MB, %6.1f MB/s)\n",
+                    nodes, firstMs, svgMs, svgBytes.bytes / 1e6, svgBytes.bytes / 1e3 / svgMs,
+                    dotMs, dotBytes.bytes / 1e6, dotBytes.bytes / 1e3 / dotMs);
+    }
+}
+
+// The display of the first version - one recursive call per node and std::endl after every key
+template <typename T, size_t K>
+void recursiveDisplay(typename Tree<T, K>::Node* node, int indent, std::ostream& out) {
+    if (!node) return;
+    for (int i = 0; i < indent; ++i) out << "  ";
+    out << node->key << std::endl;
+    for (size_t i = 0; i < K; ++i) {
+        recursiveDisplay<T, K>(node->children[i], indent + 1, out);
+    }
+}
+
+// Tree::display against the recursive version that flushes every line, both into /dev/null (one write per flush)
+void benchDisplay(const std::vector<int>& keys, const std::vector<size_t>& sizes) {
+    std::ofstream sink("/dev/null");
+    for (size_t nodes : sizes) {
+        Tree<int> tree;
+        buildTree(tree, std::vector<int>(keys.begin(), keys.begin() + nodes));
+        double recursiveMs = measureMs([&]() { recursiveDisplay<int, 2>(tree.get_root(), 0, sink); });
+        double displayMs = measureMs([&]() { tree.display(sink); });
+        double limitedMs = measureMs([&]() { tree.display(sink, 10); });
+        std::printf("  %8zu nodes   recursive + endl %8.1f ms   display %7.1f ms (x%.1f)   depth <= 10 %6.2f ms\n",
+                    nodes, recursiveMs, displayMs, recursiveMs / displayMs, limitedMs);
+    }
+}
+
+int main() {
+    const size_t count = 1 << 21;
+    std::vector<int> keys = randomKeys(count);
+
+    std::printf("K-ary heap: heapify and pop throughput (%zu keys)\n", count);
+    benchHeapArity<2>(keys);
+    benchHeapArity<4>(keys);
+    benchHeapArity<8>(keys);
+
+    std::vector<Complex> complexKeys = randomComplexKeys(count);
+    std::printf("\nTree<Complex> sort, heapify and sum (%zu keys)\n", count);
+    benchComplexOrdering(complexKeys);
+    benchComplexSum(complexKeys);
+    benchComplexScalar<double>("Complex", complexKeys);
+    benchComplexScalar<float>("FloatComplex", complexKeys);
+
+    std::printf("\nComplexArray batch kernels (%zu keys)\n", complexKeys.size());
+    benchComplexArray(complexKeys);
+
+    std::printf("\nComplex text IO (%zu values)\n", complexKeys.size());
+    benchComplexText(complexKeys);
+
+    std::vector<int> queueKeys(keys.begin(), keys.begin() + count / 4);
+    std::printf("\nTree<int> heap operations (%zu keys)\n", queueKeys.size());
+    benchHeapOperations(queueKeys);
+
+    std::printf("\nFind by key (%zu keys)\n", queueKeys.size());
+    benchKeyIndex(queueKeys, 1000);
+
+    std::printf("\nTree heap vs implicit ArrayHeap (%zu keys)\n", queueKeys.size());
+    benchArrayHeap(queueKeys);
+
+    std::printf("\nTop-k selection (%zu keys)\n", keys.size());
+    benchTopK(keys, 100);
+
+    std::vector<int> meldKeys(keys.begin(), keys.begin() + count / 16);
+    std::printf("\nMerging 256 queues (%zu keys): meld vs rebuild and heapify\n", meldKeys.size());
+    benchMeldableHeaps(meldKeys, 256);
+
+    std::printf("\nDrawing a 1000-node tree\n");
+    benchDrawFrame(1000, 20);
+    benchTreeGeometry(10000);
+
+    std::printf("\nHeadless frame build (TreeRenderer::build, whole tree at full detail)\n");
+    benchFrameBuild({10000, 100000});
+
+    std::printf("\nTidy tree layout\n");
+    benchTidyLayout({1000, 10000, 100000, 1000000});
+
+    std::printf("\nViewport culling (800x600 view, panned every frame)\n");
+    benchCulledFrame({10000, 100000, 1000000});
+
+    std::printf("\nLevel of detail (whole tree in an 800x600 view)\n");
+    benchLevelOfDetail({10000, 100000, 1000000});
+
+    std::printf("\nHeadless PNG / PPM export (layout, tiles and encoding)\n");
+    benchRaster(100000, 4096, 2048);
+
+    std::printf("\nSVG / DOT export (streamed, bytes counted)\n");
+    benchExport({100000, 1000000, 10000000});
+
+    std::printf("\nTree display (complete binary tree into /dev/null)\n");
+    benchDisplay(keys, {100000, 1000000});
+
+    std::vector<int> largeKeys = randomKeys(count * 4);
+    std::printf("\nParallel heapify (%zu keys, %u hardware threads)\n", largeKeys.size(), worker_count());
+    benchParallelHeap(largeKeys);
+
+    return 0;
+}
@@ -2,6 +2,11 @@
 #include "doctest.h"
 #include "Complex.hpp"
 #include "Tree.hpp"
+#include "ArrayHeap.hpp"
+#include "MeldableHeap.hpp"
+#include "ComplexArray.hpp"
+#include <random>
+#include <cstdint>
 
 TEST_CASE("Complex Number Constructor Default") {
     Complex c1;
@@ -402,6 +407,60 @@ TEST_CASE("BinaryTree Display") {
     CHECK_NOTHROW(tree.display());
 }
 
+TEST_CASE("Tree - display to a stream with depth and node limits") {
+    ariel::Tree<int, 3> tree;
+    tree.add_root(1);
+    auto root = tree.get_root();
+    tree.add_sub_node(root, 2);
+    tree.add_sub_node(root, 3);
+    tree.add_sub_node(root->children[0], 4);
+    tree.add_sub_node(root->children[0], 5);
+    tree.add_sub_node(root->children[1], 6);
+    tree.add_sub_node(root->children[0]->children[1], 7);
+
+    std::ostringstream all;
+    tree.display(all);
+    CHECK(all.str() == "1\n  2\n    4\n    5\n      7\n  3\n    6\n");
+
+    std::ostringstream shallow;
+    tree.display(shallow, 1);
+    CHECK(shallow.str() == "1\n  2\n  3\n");
+
+    std::ostringstream first;
+    tree.display(first, ariel::NoLimit, 4);
+    CHECK(first.str() == "1\n  2\n    4\n    5\n");
+
+    std::ostringstream none;
+    ariel::Tree<int> empty;
+    empty.display(none);
+    CHECK(none.str().empty());
+
+    // Keys are printed in the format of the stream
+    ariel::Tree<double> real;
+    real.add_root(0.5);
+    real.add_sub_node(real.get_root(), 2);
+    std::ostringstream fixed;
+    fixed << std::fixed;
+    fixed.precision(2);
+    real.display(fixed);
+    CHECK(fixed.str() == "0.50\n  2.00\n");
+
+    // A long path - the walk keeps no stack and stops at the limits
+    ariel::Tree<int, 1> path;
+    path.add_root(0);
+    auto last = path.get_root();
+    for (int i = 1; i < 20000; ++i) {
+        path.add_sub_node(last, i);
+        last = last->children[0];
+    }
+    std::ostringstream top;
+    path.display(top, ariel::NoLimit, 3);
+    CHECK(top.str() == "0\n  1\n    2\n");
+    std::ostringstream bottom;
+    path.display(bottom, 2);
+    CHECK(bottom.str() == "0\n  1\n    2\n");
+}
+
 TEST_CASE("BinaryTree - myHeap"){
     ariel::Tree<int> tree;
     tree.add_root(2);
@@ -440,12 +499,54 @@ TEST_CASE("BinaryTree - myHeap"){
 
 TEST_CASE("Tree - myHeap"){
     ariel::Tree<int,3> tree;
-    tree.add_root(1);
+    tree.add_root(9);
     auto root = tree.get_root();
-    tree.add_sub_node(root, 2);
-    tree.add_sub_node(root, 3);
     tree.add_sub_node(root, 4);
-    CHECK_THROWS(tree.myHeap());
+    tree.add_sub_node(root, 7);
+    tree.add_sub_node(root, 2);
+    auto child1 = root->children[0];
+    tree.add_sub_node(child1, 8);
+    tree.add_sub_node(child1, 1);
+    tree.add_sub_node(child1, 6);
+    auto child3 = root->children[2];
+    tree.add_sub_node(child3, 3);
+    CHECK_NOTHROW(tree.myHeap());
+
+    // Collect the heap in BFS order - the children of element i are at 3*i+1 ... 3*i+3
+    std::vector<int> heap;
+    for (auto it = tree.begin_bfs(); it != tree.end_bfs(); ++it) {
+        heap.push_back(*it);
+    }
+    CHECK(heap.size() == 8);
+    CHECK(heap[0] == 1);
+    for (size_t i = 1; i < heap.size(); ++i) {
+        CHECK(heap[(i - 1) / 3] <= heap[i]);
+    }
+
+    // The rebuilt tree is complete - every level is filled from the left
+    root = tree.get_root();
+    CHECK(root->children[0]->children[2] != nullptr);
+    CHECK(root->children[1]->children[0] != nullptr);
+    CHECK(root->children[1]->children[1] == nullptr);
+}
+
+TEST_CASE("Tree K=4 - myHeap"){
+    ariel::Tree<int,4> tree;
+    tree.add_root(10);
+    auto root = tree.get_root();
+    for (int key = 9; key >= 1; --key) {
+        auto parent = root->children[3] ? root->children[(9 - key) % 4] : root;
+        tree.add_sub_node(parent, key);
+    }
+    auto it = tree.myHeap();
+    CHECK(*it == 1);
+
+    std::vector<int> heap;
+    for (; it != tree.end_bfs(); ++it) {
+        heap.push_back(*it);
+    }
+    CHECK(heap.size() == 10);
+    CHECK(ariel::is_kary_heap<4>(heap.begin(), heap.end(), std::greater<int>()));
 }
 
 TEST_CASE("Tree Display") {
@@ -467,7 +568,7 @@ TEST_CASE("Tree Display") {
     tree.add_sub_node(child3, 11);
     tree.add_sub_node(child3, 12);
     tree.add_sub_node(child3, 13);
-    CHECK_NOTHROW(tree.display());  // check No exception is thrown (display and displayHelper functions)
+    CHECK_NOTHROW(tree.display());  // check No exception is thrown (display function)
 
     sf::RenderWindow window2(sf::VideoMode(800, 600), "Tree <int, 3> Drawing");
     while (window2.isOpen()) {
@@ -523,3 +624,1279 @@ TEST_CASE("Tree K=2 Try insert 3 Childrens"){
     delete tree;    
 }
 
+
+TEST_CASE("BinaryTree - myHeap with comparator (max-heap)"){
+    ariel::Tree<int> tree;
+    tree.add_root(2);
+    auto root = tree.get_root();
+    tree.add_sub_node(root, 5);
+    tree.add_sub_node(root, 3);
+    tree.add_sub_node(root->children[0], 8);
+    tree.add_sub_node(root->children[1], 1);
+    auto it = tree.myHeap(std::less<int>());  // std::less gives a max-heap, like std::make_heap
+    CHECK(*it == 8);
+
+    std::vector<int> heap;
+    for (; it != tree.end_bfs(); ++it) {
+        heap.push_back(*it);
+    }
+    CHECK(heap.size() == 5);
+    CHECK(ariel::is_kary_heap<2>(heap.begin(), heap.end(), std::less<int>()));
+}
+
+TEST_CASE("BinaryTree - myHeap with key projection"){
+    ariel::Tree<Complex> tree;
+    tree.add_root(Complex(3, 4));
+    auto root = tree.get_root();
+    tree.add_sub_node(root, Complex(5, 12));
+    tree.add_sub_node(root, Complex(0, 1));
+    tree.add_sub_node(root->children[0], Complex(-2, 0));
+    tree.add_sub_node(root->children[0], Complex(6, 8));
+
+    // Order by squared magnitude, the projection runs exactly once per node
+    int projections = 0;
+    auto it = tree.myHeap(std::greater<double>(), [&projections](const Complex& c) {
+        ++projections;
+        return c.norm();
+    });
+    CHECK(projections == 5);
+    CHECK((*it).re() == doctest::Approx(0));
+    CHECK((*it).im() == doctest::Approx(1));
+
+    std::vector<double> norms;
+    for (; it != tree.end_bfs(); ++it) {
+        norms.push_back((*it).norm());
+    }
+    CHECK(norms.size() == 5);
+    CHECK(ariel::is_kary_heap<2>(norms.begin(), norms.end(), std::greater<double>()));
+}
+
+TEST_CASE("BinaryTree - heap push, peek and pop_min"){
+    ariel::Tree<int> tree;
+    int keys[] = {7, 3, 9, 1, 8, 2, 6, 4, 5, 0};
+    for (int key : keys) {
+        tree.push(key);
+    }
+    CHECK(tree.size() == 10);
+    CHECK(tree.peek() == 0);
+
+    // The heap stays a complete tree - the last node is the right child of the root's left child's right child
+    CHECK(tree.get_root()->children[0]->children[1]->children[0] != nullptr);
+    CHECK(tree.get_root()->children[0]->children[1]->children[0]->parent == tree.get_root()->children[0]->children[1]);
+
+    for (int expected = 0; expected < 10; ++expected) {
+        CHECK(tree.pop_min() == expected);
+    }
+    CHECK(tree.size() == 0);
+    CHECK(tree.get_root() == nullptr);
+    CHECK_THROWS_AS(tree.pop_min(), std::out_of_range);
+    CHECK_THROWS_AS(tree.peek(), std::out_of_range);
+}
+
+TEST_CASE("BinaryTree - heap operations after myHeap and decrease_key"){
+    ariel::Tree<int> tree;
+    tree.add_root(2);
+    auto root = tree.get_root();
+    tree.add_sub_node(root, 5);
+    tree.add_sub_node(root, 3);
+    tree.add_sub_node(root->children[0], 8);
+    CHECK_THROWS_AS(tree.push(1), std::logic_error);  // not a heap yet
+
+    tree.myHeap();
+    tree.push(4);
+    tree.push(6);
+    CHECK(tree.size() == 6);
+
+    // Find the node holding 8 and raise its priority
+    ariel::Tree<int>::Node* node = nullptr;
+    std::queue<ariel::Tree<int>::Node*> nodes;
+    nodes.push(tree.get_root());
+    while (!nodes.empty()) {
+        node = nodes.front();
+        nodes.pop();
+        if (node->key == 8) break;
+        for (auto child : node->children) {
+            if (child) nodes.push(child);
+        }
+    }
+    CHECK(node->key == 8);
+    CHECK_THROWS_AS(tree.decrease_key(node, 9), std::invalid_argument);
+    tree.decrease_key(node, 1);
+    CHECK(tree.peek() == 1);
+
+    int expected[] = {1, 2, 3, 4, 5, 6};
+    for (int key : expected) {
+        CHECK(tree.pop_min() == key);
+    }
+}
+
+TEST_CASE("Tree K=3 - heap push and pop_min (max-heap)"){
+    ariel::Tree<int, 3> tree;
+    for (int key = 0; key < 20; ++key) {
+        tree.push((key * 7) % 20, std::less<int>());
+    }
+    CHECK(tree.peek() == 19);
+    for (int expected = 19; expected >= 0; --expected) {
+        CHECK(tree.pop_min(std::less<int>()) == expected);
+    }
+}
+
+TEST_CASE("parallel_for - exceptions reach the caller after every thread is joined") {
+    std::vector<int> done(8, 0);
+    auto failAt = [&](size_t failing) {
+        return [&done, failing](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (i == failing) throw std::runtime_error("chunk failed");
+                done[i] = 1;
+            }
+        };
+    };
+
+    // A worker chunk throws - the calling thread's chunk still finishes
+    CHECK_THROWS_AS(ariel::parallel_for(0, 8, 4, failAt(6)), std::runtime_error);
+    CHECK(done[0] == 1);
+    CHECK(done[1] == 1);
+
+    // The calling thread's own chunk throws - the workers are joined, not left running
+    std::fill(done.begin(), done.end(), 0);
+    CHECK_THROWS_AS(ariel::parallel_for(0, 8, 4, failAt(0)), std::runtime_error);
+    CHECK(done[7] == 1);
+
+    std::fill(done.begin(), done.end(), 0);
+    CHECK_NOTHROW(ariel::parallel_for(0, 8, 4, failAt(100)));
+    CHECK(std::count(done.begin(), done.end(), 1) == 8);
+}
+
+TEST_CASE("Tree - myHeapParallel"){
+    // Large enough to take the parallel path - keys are a permutation of 0 ... size - 1
+    const int size = static_cast<int>(ariel::Tree<int, 3>::ParallelHeapThreshold) + 1000;
+    ariel::Tree<int, 3> tree;
+    tree.add_root(0);
+    std::queue<ariel::Tree<int, 3>::Node*> parents;
+    parents.push(tree.get_root());
+    for (int i = 1; i < size;) {
+        auto parent = parents.front();
+        parents.pop();
+        for (size_t c = 0; c < 3 && i < size; ++c, ++i) {
+            tree.add_sub_node(parent, static_cast<int>((i * 7919L) % size));
+            parents.push(parent->children[c]);
+        }
+    }
+
+    auto it = tree.myHeapParallel(std::greater<int>(), 4);
+    CHECK(*it == 0);
+    std::vector<int> heap;
+    for (; it != tree.end_bfs(); ++it) {
+        heap.push_back(*it);
+    }
+    CHECK(heap.size() == static_cast<size_t>(size));
+    CHECK(tree.size() == static_cast<size_t>(size));
+    CHECK(ariel::is_kary_heap<3>(heap.begin(), heap.end(), std::greater<int>()));
+    std::sort(heap.begin(), heap.end());
+    CHECK(heap.back() == size - 1);
+    CHECK(std::adjacent_find(heap.begin(), heap.end()) == heap.end());
+
+    // The heap operations keep working on the parallel-built tree
+    tree.push(-1);
+    CHECK(tree.pop_min() == -1);
+    CHECK(tree.pop_min() == 0);
+}
+
+TEST_CASE("ArrayHeap - from Tree, iterators and heap operations"){
+    ariel::Tree<int> tree;
+    tree.add_root(2);
+    auto root = tree.get_root();
+    tree.add_sub_node(root, 5);
+    tree.add_sub_node(root, 3);
+    tree.add_sub_node(root->children[0], 8);
+    tree.add_sub_node(root->children[0], 7);
+    tree.add_sub_node(root->children[1], 4);
+
+    ariel::ArrayHeap<int> heap(tree);
+    CHECK(heap.size() == 6);
+    CHECK(heap.peek() == 2);
+    CHECK(ariel::is_kary_heap<2>(heap.keys().begin(), heap.keys().end(), std::greater<int>()));
+
+    // BFS walks the array, DFS follows the computed children (same order as the tree after myHeap)
+    tree.myHeap();
+    auto treeBfs = tree.begin_bfs();
+    for (auto it = heap.begin_bfs(); it != heap.end_bfs(); ++it, ++treeBfs) {
+        CHECK(*it == *treeBfs);
+    }
+    auto treeDfs = tree.begin_dfs();
+    for (auto it = heap.begin_dfs(); it != heap.end_dfs(); ++it, ++treeDfs) {
+        CHECK(*it == *treeDfs);
+    }
+    CHECK(!(treeDfs != tree.end_dfs()));
+
+    heap.push(1);
+    heap.decrease_key(heap.size() - 2, 0);
+    CHECK_THROWS_AS(heap.decrease_key(0, 9), std::invalid_argument);
+    int expected[] = {0, 1, 2, 3, 5, 7, 8};
+    for (int key : expected) {
+        CHECK(heap.pop_min() == key);
+    }
+    CHECK(heap.empty());
+    CHECK_THROWS_AS(heap.pop_min(), std::out_of_range);
+}
+
+TEST_CASE("ArrayHeap K=4 - max-heap"){
+    std::vector<int> keys;
+    for (int key = 0; key < 50; ++key) {
+        keys.push_back((key * 13) % 50);
+    }
+    ariel::ArrayHeap<int, 4, std::less<int>> heap(keys.begin(), keys.end());
+    CHECK(ariel::ArrayHeap<int, 4>::parent(5) == 1);
+    CHECK(ariel::ArrayHeap<int, 4>::child(1, 3) == 8);
+    for (int expected = 49; expected >= 0; --expected) {
+        CHECK(heap.pop_min() == expected);
+    }
+}
+
+TEST_CASE("Tree - top_k"){
+    ariel::Tree<int, 3> tree;
+    tree.add_root(9);
+    auto root = tree.get_root();
+    tree.add_sub_node(root, 4);
+    tree.add_sub_node(root, 7);
+    tree.add_sub_node(root, 2);
+    tree.add_sub_node(root->children[0], 8);
+    tree.add_sub_node(root->children[0], 1);
+    tree.add_sub_node(root->children[2], 3);
+
+    std::vector<int> smallest = tree.top_k(3);
+    CHECK(smallest == std::vector<int>({1, 2, 3}));
+    std::vector<int> largest = tree.top_k(2, std::greater<int>());
+    CHECK(largest == std::vector<int>({9, 8}));
+    CHECK(tree.top_k(100).size() == 7);
+    CHECK(tree.top_k(0).empty());
+    CHECK(tree.get_root()->key == 9);  // the tree is not changed
+
+    // k larger than the tree - memory follows the number of nodes, not k
+    std::vector<int> all = tree.top_k(1000000000);
+    CHECK(all == std::vector<int>({1, 2, 3, 4, 7, 8, 9}));
+    CHECK_NOTHROW(tree.top_k(SIZE_MAX));
+    CHECK(tree.top_k(SIZE_MAX) == all);
+    CHECK(tree.top_k_parallel(SIZE_MAX, std::less<int>(), 4) == all);
+    CHECK(ariel::top_k(tree.begin_in_order(), tree.end_in_order(), SIZE_MAX, std::less<int>()).size() == 7);
+
+    // Any traversal can be streamed through the free function
+    std::vector<int> inOrder = ariel::top_k(tree.begin_in_order(), tree.end_in_order(), 2, std::less<int>());
+    CHECK(inOrder == std::vector<int>({1, 2}));
+}
+
+TEST_CASE("Tree - top_k_parallel"){
+    ariel::Tree<int> tree;
+    for (int key = 0; key < static_cast<int>(ariel::Tree<int>::ParallelHeapThreshold) + 500; ++key) {
+        tree.push((key * 7919) % 70000);
+    }
+    std::vector<int> serial = tree.top_k(25);
+    std::vector<int> parallel = tree.top_k_parallel(25, std::less<int>(), 4);
+    CHECK(serial.size() == 25);
+    CHECK(serial == parallel);
+    CHECK(std::is_sorted(parallel.begin(), parallel.end()));
+}
+
+TEST_CASE_TEMPLATE("MeldableHeap - push, meld and pop_min", Heap,
+                   ariel::MeldableHeap<int, ariel::MeldDiscipline::Skew>,
+                   ariel::MeldableHeap<int, ariel::MeldDiscipline::Pairing>){
+    Heap first;
+    Heap second;
+    for (int key = 0; key < 200; ++key) {
+        if (key % 2 == 0) {
+            first.push((key * 37) % 200);
+        } else {
+            second.push((key * 37) % 200);
+        }
+    }
+    CHECK(first.size() == 100);
+    CHECK(first.peek() == 0);
+    CHECK(second.peek() == 1);
+
+    first.meld(second);
+    CHECK(second.empty());
+    CHECK(first.size() == 200);
+    for (int expected = 0; expected < 200; ++expected) {
+        CHECK(first.pop_min() == expected);
+    }
+    CHECK(first.empty());
+    CHECK_THROWS_AS(first.pop_min(), std::out_of_range);
+}
+
+TEST_CASE("MeldableHeap - from Tree (max-heap)"){
+    ariel::Tree<int> tree;
+    tree.add_root(2);
+    auto root = tree.get_root();
+    tree.add_sub_node(root, 5);
+    tree.add_sub_node(root, 3);
+    tree.add_sub_node(root->children[0], 8);
+
+    ariel::MeldableHeap<int, ariel::MeldDiscipline::Skew, std::less<int>> heap(tree, std::less<int>());
+    CHECK(heap.peek() == 8);
+    CHECK(heap.get_root()->key == 8);
+    int expected[] = {8, 5, 3, 2};
+    for (int key : expected) {
+        CHECK(heap.pop_min() == key);
+    }
+}
+
+TEST_CASE("Complex Number constexpr arithmetic") {
+    constexpr Complex a(1, 2);
+    constexpr Complex b(3, -1);
+    constexpr Complex sum = a + b;
+    constexpr Complex product = a * b;  // (1+2i)(3-i) = 3 - i + 6i - 2i^2 = 5+5i
+    static_assert(sum.re() == 4 && sum.im() == 1, "constexpr operator+");
+    static_assert(product.re() == 5 && product.im() == 5, "constexpr operator*");
+    static_assert(Complex(3, 4).norm() == 25, "constexpr norm");
+    static_assert(a != b && !Complex(), "constexpr comparison");
+    CHECK(sum == Complex(4, 1));
+}
+
+TEST_CASE("Complex Number Comparison without overflow") {
+    // Squared magnitudes of these numbers overflow (or underflow) a double, the order must still be right
+    Complex huge1(1e200, 1e200);
+    Complex huge2(2e200, 0);
+    CHECK(huge1 < huge2);  // |huge1| = 1.414e200 < 2e200
+    CHECK(huge2 > huge1);
+    CHECK(!(huge2 < huge1));
+
+    Complex tiny1(1e-200, 0);
+    Complex tiny2(0, 2e-200);
+    CHECK(tiny1 < tiny2);
+    CHECK(Complex() < tiny1);
+    CHECK(Complex() < Complex(1e-200, 0));
+    CHECK(!(Complex(1e-200, 0) < Complex()));
+    CHECK(!(Complex() < Complex()));
+    CHECK(Complex() < Complex(1, 0));
+    CHECK(!(Complex(0, -1) < Complex()));
+    CHECK(tiny1 < Complex(1, 0));
+    CHECK(Complex(1e300, 0) < Complex(INFINITY, 0));
+
+    // Equal magnitudes are neither < nor >
+    Complex a(3, 4);
+    Complex b(-5, 0);
+    CHECK(!(a < b));
+    CHECK(!(a > b));
+    static_assert(Complex(3, 4) < Complex(5, 12), "constexpr operator<");
+    static_assert(Complex() < Complex(5, 12) && !(Complex() < Complex()), "constexpr operator< with zero");
+}
+
+TEST_CASE("NormedComplex - cached norm ordering") {
+    NormedComplex a(Complex(3, 4));
+    NormedComplex b(Complex(5, 12));
+    CHECK(a.norm() == doctest::Approx(25));
+    CHECK(a < b);
+    CHECK(b > a);
+    CHECK(a.value() == Complex(3, 4));
+
+    ariel::Tree<NormedComplex> tree;
+    tree.add_root(NormedComplex(Complex(6, 8)));
+    tree.add_sub_node(tree.get_root(), NormedComplex(Complex(1, 1)));
+    tree.add_sub_node(tree.get_root(), NormedComplex(Complex(0, 3)));
+    auto it = tree.myHeap();
+    CHECK((*it).value() == Complex(1, 1));
+
+    std::stringstream ss;
+    ss << *it;
+    CHECK(ss.str() == "1+1i");
+}
+
+TEST_CASE("ComplexArray - batch kernels match Complex operators") {
+    // 11 values - exercises the vector loops and the scalar tail
+    std::vector<Complex> first;
+    std::vector<Complex> second;
+    for (int i = 0; i < 11; ++i) {
+        first.push_back(Complex(i - 5.5, 2.0 * i));
+        second.push_back(Complex(0.5 * i, 3 - i));
+    }
+    ComplexArray a(first.begin(), first.end());
+    ComplexArray b(second.begin(), second.end());
+    CHECK(a.size() == 11);
+
+    ComplexArray sum;
+    ComplexArray product;
+    ComplexArray accumulator(a.size());
+    std::vector<double> norms;
+    ComplexArray::add(a, b, sum);
+    ComplexArray::multiply(a, b, product);
+    ComplexArray::multiply_add(a, b, accumulator);
+    ComplexArray::multiply_add(a, b, accumulator);
+    ComplexArray::norm(a, norms);
+    for (size_t i = 0; i < first.size(); ++i) {
+        Complex expectedProduct = first[i] * second[i];
+        CHECK(sum[i].re() == doctest::Approx((first[i] + second[i]).re()));
+        CHECK(sum[i].im() == doctest::Approx((first[i] + second[i]).im()));
+        CHECK(product[i].re() == doctest::Approx(expectedProduct.re()));
+        CHECK(product[i].im() == doctest::Approx(expectedProduct.im()));
+        CHECK(accumulator[i].re() == doctest::Approx(2 * expectedProduct.re()));
+        CHECK(accumulator[i].im() == doctest::Approx(2 * expectedProduct.im()));
+        CHECK(norms[i] == doctest::Approx(first[i].norm()));
+    }
+
+    // argmin - b[i] = (0.5 * i) + (3 - i)i, the smallest magnitude is b[2] = 1+1i
+    CHECK(ComplexArray::argmin_norm(b) == 2);
+    b.set(9, Complex(0, 0.5));
+    CHECK(ComplexArray::argmin_norm(b) == 9);
+    CHECK(ComplexArray::argmin_norm(ComplexArray()) == 0);
+
+    ComplexArray shorter(3);
+    CHECK_THROWS_AS(ComplexArray::add(a, shorter, sum), std::invalid_argument);
+    CHECK(std::string(ComplexArray::backend()).size() > 0);
+}
+
+TEST_CASE("ComplexArray - every backend rounds like Complex") {
+    // Random parts - a fused multiply-add would change the last bit of some products and norms
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> part(-1000, 1000);
+    std::vector<Complex> first, second;
+    for (int i = 0; i < 103; ++i) {  // vector body and scalar tail on every backend
+        first.push_back(Complex(part(generator), part(generator)));
+        second.push_back(Complex(part(generator), part(generator)));
+    }
+    ComplexArray a(first.begin(), first.end());
+    ComplexArray b(second.begin(), second.end());
+
+    std::string detected = ComplexArray::backend();
+    for (const char* name : {"scalar", "sse2", "avx2"}) {
+        if (!ComplexArray::use_backend(name)) continue;  // not supported by this CPU
+        CAPTURE(name);
+        ComplexArray product;
+        ComplexArray accumulator(a.size());
+        std::vector<double> norms;
+        ComplexArray::multiply(a, b, product);
+        ComplexArray::multiply_add(a, b, accumulator);
+        ComplexArray::multiply_add(a, b, accumulator);
+        ComplexArray::norm(a, norms);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < first.size(); ++i) {
+            Complex expected = first[i] * second[i];
+            double accRe = 0, accIm = 0;
+            accRe += expected.re();
+            accIm += expected.im();
+            accRe += expected.re();
+            accIm += expected.im();
+            if (product[i].re() != expected.re() || product[i].im() != expected.im()) mismatches++;
+            if (accumulator[i].re() != accRe || accumulator[i].im() != accIm) mismatches++;
+            if (norms[i] != first[i].norm()) mismatches++;
+        }
+        CHECK(mismatches == 0);
+    }
+    CHECK(ComplexArray::use_backend(detected));
+}
+
+TEST_CASE("ComplexArray - argmin ties give the first index on every backend") {
+    // a+bi and b+ai have equal norms when rounded like the scalar loop, but not with fma(a, a, b*b)
+    const double a = 0.81118497782730281;
+    const double b = 0.45327153782852625;
+    std::vector<Complex> values(11, Complex(10, 10));
+    values[1] = Complex(b, a);
+    values[6] = Complex(a, b);
+    ComplexArray array(values.begin(), values.end());
+
+    std::vector<Complex> equal(9, Complex(3, 4));  // the same norm in every lane
+    ComplexArray same(equal.begin(), equal.end());
+
+    // Random values with repeated minima in every lane and in the tail - the scalar answer is the reference
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> small(-3, 3);
+    ComplexArray mixed;
+    for (int i = 0; i < 103; ++i) mixed.push_back(Complex(small(generator), small(generator)));
+    std::string detected = ComplexArray::backend();
+    REQUIRE(ComplexArray::use_backend("scalar"));
+    size_t expected = ComplexArray::argmin_norm(mixed);
+
+    for (const char* name : {"scalar", "sse2", "avx2"}) {
+        if (!ComplexArray::use_backend(name)) continue;  // not supported by this CPU
+        CAPTURE(name);
+        CHECK(ComplexArray::argmin_norm(mixed) == expected);
+        CHECK(ComplexArray::argmin_norm(array) == 1);
+        CHECK(ComplexArray::argmin_norm(same) == 0);
+        values[0] = Complex(std::nan(""), 0);
+        CHECK(ComplexArray::argmin_norm(ComplexArray(values.begin(), values.end())) == 0);
+        values[0] = Complex(10, 10);
+    }
+    CHECK(ComplexArray::use_backend(detected));
+    CHECK(!ComplexArray::use_backend("neon"));
+}
+
+TEST_CASE("ComplexArray - gather from Tree<Complex>") {
+    ariel::Tree<Complex> tree;
+    tree.add_root(Complex(1, 1));
+    tree.add_sub_node(tree.get_root(), Complex(2, 2));
+    tree.add_sub_node(tree.get_root(), Complex(3, 3));
+    tree.add_sub_node(tree.get_root()->children[0], Complex(4, 4));
+
+    ComplexArray array = ComplexArray::gather(tree);
+    CHECK(array.size() == 4);
+    int i = 0;
+    for (auto it = tree.begin_pre_order(); it != tree.end_pre_order(); ++it, ++i) {
+        CHECK(array[i] == *it);  // the gather walks the tree in pre-order
+    }
+}
+
+TEST_CASE("Complex Number bulk parse") {
+    ComplexParseResult result = parse_complex_buffer("3+4i 5-6i\n-1.5e2+0.25i\t+7-0i bad 8+9 2+3i");
+    REQUIRE(result.values.size() == 5);
+    CHECK(result.values[0] == Complex(3, 4));
+    CHECK(result.values[1] == Complex(5, -6));
+    CHECK(result.values[2] == Complex(-150, 0.25));
+    CHECK(result.values[3] == Complex(7, 0));
+    CHECK(result.values[4] == Complex(2, 3));
+    REQUIRE(result.errors.size() == 2);
+    CHECK(result.errors[0] == 29);  // "bad"
+    CHECK(result.errors[1] == 33);  // "8+9" - no 'i'
+
+    // Chunked input - a literal cut by the end of a chunk is parsed with the next chunk
+    std::string text = "1+1i 2-2i 3+3i";
+    ComplexParseResult chunked;
+    parse_complex_buffer(text.data(), 7, chunked, false);
+    CHECK(chunked.values.size() == 1);
+    CHECK(chunked.consumed == 5);
+    parse_complex_buffer(text.data() + chunked.consumed, text.size() - chunked.consumed, chunked);
+    REQUIRE(chunked.values.size() == 3);
+    CHECK(chunked.values[2] == Complex(3, 3));
+    CHECK(chunked.errors.empty());
+}
+
+TEST_CASE("Complex Number bulk format") {
+    std::vector<Complex> values = {Complex(3, 4), Complex(5, -6), Complex(0.1, 1.0 / 3), Complex(-2.5e20, 0)};
+
+    // precision 6 matches operator<<
+    std::ostringstream ss;
+    for (const Complex& value : values) {
+        ss << value << ' ';
+    }
+    CHECK(format_complex_buffer(values, 6, ' ') == ss.str());
+    CHECK(format_complex_buffer(values, -1, ' ').substr(0, 10) == "3+4i 5-6i ");
+
+    // The shortest form reads back to the same values
+    ComplexParseResult result = parse_complex_buffer(format_complex_buffer(values));
+    REQUIRE(result.values.size() == values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        CHECK(result.values[i] == values[i]);
+    }
+}
+
+TEST_CASE("FloatComplex - float instantiation") {
+    CHECK(sizeof(FloatComplex) == 2 * sizeof(float));
+    CHECK(sizeof(Complex) == 2 * sizeof(double));
+
+    FloatComplex a(3, 4);
+    FloatComplex b(1.5f, -2);
+    CHECK((a + b) == FloatComplex(4.5f, 2));
+    CHECK((a * b) == FloatComplex(12.5f, -0.0f));
+    CHECK(a.norm() == 25.0f);
+    CHECK(b < a);
+    CHECK(a > b);
+    CHECK(FloatComplex(2e20f, 2e20f) < FloatComplex(3e20f, 0));  // norms overflow float, compared scaled
+    CHECK_FALSE(FloatComplex(3e20f, 0) < FloatComplex(2e20f, 2e20f));
+
+    std::stringstream ss;
+    ss << b;
+    CHECK(ss.str() == "1.5-2i");
+    FloatComplex read;
+    ss >> read;
+    CHECK(read == b);
+
+    // Conversion between the scalar types
+    CHECK(Complex(FloatComplex(0.5f, 0.25f)) == Complex(0.5, 0.25));
+    CHECK(FloatComplex(Complex(0.1, 0.2)) == FloatComplex(0.1f, 0.2f));
+
+    ariel::Tree<FloatComplex> tree;
+    tree.add_root(FloatComplex(5, 5));
+    tree.add_sub_node(tree.get_root(), FloatComplex(1, 1));
+    tree.add_sub_node(tree.get_root(), FloatComplex(3, 3));
+    tree.myHeap();
+    CHECK(tree.get_root()->key == FloatComplex(1, 1));
+    FloatNormedComplex normed(a);
+    CHECK(normed.norm() == 25.0f);
+}
+
+// A key with ordering, equality and printing but no std::hash - the index is not required to use the tree
+struct UnhashableKey {
+    int value;
+    bool operator<(const UnhashableKey& other) const { return value < other.value; }
+    bool operator==(const UnhashableKey& other) const { return value == other.value; }
+};
+
+std::ostream& operator<<(std::ostream& out, const UnhashableKey& key) {
+    return out << '#' << key.value;
+}
+
+TEST_CASE("Tree - keys without std::hash") {
+    ariel::Tree<UnhashableKey> tree;
+    tree.add_root(UnhashableKey{3});
+    tree.add_sub_node(tree.get_root(), UnhashableKey{1});
+    tree.add_sub_node(tree.get_root(), UnhashableKey{2});
+    tree.myHeap(std::less<UnhashableKey>());  // max-heap
+    CHECK(tree.get_root()->key.value == 3);
+    CHECK(!tree.has_index());
+    CHECK(tree.find(UnhashableKey{2}) != nullptr);  // BFS search
+    CHECK(tree.find(UnhashableKey{7}) == nullptr);
+    CHECK(tree.index_stats().entries == 0);
+
+    std::ostringstream out;
+    tree.display(out);
+    CHECK(out.str().substr(0, 3) == "#3\n");
+}
+
+TEST_CASE("Tree - key index and find") {
+    ariel::Tree<int> tree;
+    tree.add_root(5);
+    tree.add_sub_node(tree.get_root(), 9);
+    tree.add_sub_node(tree.get_root(), 3);
+    CHECK(tree.find(3) == tree.get_root()->children[1]);  // BFS without the index
+    CHECK(tree.find(7) == nullptr);
+    CHECK(tree.index_stats().entries == 0);
+
+    tree.enable_index();
+    CHECK(tree.has_index());
+    tree.add_sub_node(tree.get_root()->children[0], 7);
+    CHECK(tree.find(7) == tree.get_root()->children[0]->children[0]);
+    CHECK(tree.index_stats().entries == 4);
+    CHECK(tree.index_stats().bytes > 0);
+
+    // The index follows the keys through myHeap and the heap operations
+    tree.myHeap();
+    tree.push(1);
+    tree.push(4);
+    tree.decrease_key(tree.find(9), 0);
+    CHECK(tree.pop_min() == 0);
+    CHECK(tree.index_stats().entries == tree.size());
+    for (int key : {1, 3, 4, 5, 7}) {
+        ariel::Tree<int>::Node* node = tree.find(key);
+        REQUIRE(node != nullptr);
+        CHECK(node->key == key);
+    }
+    CHECK(tree.find(9) == nullptr);
+    CHECK(tree.find(0) == nullptr);
+
+    tree.add_root(8);  // replace the root key
+    CHECK(tree.find(1) == nullptr);
+    CHECK(tree.find(8) == tree.get_root());
+
+    tree.disable_index();
+    CHECK_FALSE(tree.has_index());
+    CHECK(tree.find(8) == tree.get_root());
+}
+
+TEST_CASE("Tree<Complex> - find with std::hash<Complex>") {
+    CHECK(std::hash<Complex>()(Complex(0.0, 1)) == std::hash<Complex>()(Complex(-0.0, 1)));
+    CHECK(std::hash<Complex>()(Complex(1, 2)) != std::hash<Complex>()(Complex(2, 1)));
+
+    ariel::Tree<Complex, 3> tree;
+    tree.enable_index();
+    tree.add_root(Complex(1, 1));
+    for (int i = 2; i < 40; ++i) {
+        tree.push(Complex(i, -i));
+    }
+    tree.myHeapParallel(std::greater<Complex>(), 2);
+    CHECK(tree.index_stats().entries == 39);
+    ariel::Tree<Complex, 3>::Node* node = tree.find(Complex(17, -17));
+    REQUIRE(node != nullptr);
+    CHECK(node->key == Complex(17, -17));
+}
+
+TEST_CASE("FontCache - default path and failed loads") {
+    std::string previous = ariel::FontCache::default_path();
+    CHECK(previous == "arial.ttf");
+    CHECK(ariel::FontCache::get("no-such-font.ttf") == nullptr);
+    CHECK(ariel::FontCache::get("no-such-font.ttf") == nullptr);  // remembered, not read again
+
+    ariel::FontCache::set_default_path("no-such-font.ttf");
+    CHECK(ariel::FontCache::default_path() == "no-such-font.ttf");
+    CHECK(ariel::FontCache::default_font() == nullptr);
+    ariel::FontCache::set_default_path(previous);
+    CHECK(ariel::FontCache::default_font() == ariel::FontCache::get("arial.ttf"));  // one font object per file
+}
+
+// A view over a vector in BFS order (binary), for the drawing functions
+struct VectorView {
+    typedef size_t Handle;
+    static const size_t arity = 2;
+    const std::vector<int>* keys;
+
+    Handle root() const { return 0; }
+    bool valid(Handle index) const { return index < keys->size(); }
+    Handle child(Handle index, size_t i) const { return 2 * index + 1 + i; }
+    const int& key(Handle index) const { return (*keys)[index]; }
+};
+
+// Tree of up to 3 children per node given by child lists - the children of node i are children[i]
+struct ListView {
+    typedef size_t Handle;
+    static const size_t arity = 3;
+    const std::vector<std::vector<size_t>>* children;
+
+    Handle root() const { return 0; }
+    bool valid(Handle index) const { return index != ariel::NoParent; }
+    Handle child(Handle index, size_t i) const { return i < (*children)[index].size() ? (*children)[index][i] : ariel::NoParent; }
+    size_t key(Handle index) const { return index; }
+};
+
+// Implicit K-ary tree of n nodes
+template <size_t K>
+struct KaryIndexView {
+    typedef size_t Handle;
+    static const size_t arity = K;
+    size_t n;
+
+    Handle root() const { return 0; }
+    bool valid(Handle index) const { return index < n; }
+    Handle child(Handle index, size_t i) const { return K * index + 1 + i; }
+    size_t key(Handle index) const { return index; }
+};
+
+// True if no two nodes of the same level are closer than NodeSpacing, and the levels are sorted from left to right
+template <typename Handle>
+bool tidyLevels(const ariel::TreeLayout<Handle>& layout) {
+    for (size_t i = 1; i < layout.size(); ++i) {
+        const sf::Vector2f& a = layout.nodes[i - 1].position;
+        const sf::Vector2f& b = layout.nodes[i].position;
+        if (a.y == b.y && b.x - a.x < ariel::NodeSpacing - 0.01f) return false;
+    }
+    return true;
+}
+
+TEST_CASE("TreeLayout - tidy layout") {
+    SUBCASE("Parents centered above their children, levels do not overlap") {
+        // 0 has children 1 2 3; 1 has 4 5 6; 3 has 7; 7 has 8 9
+        std::vector<std::vector<size_t>> children = {{1, 2, 3}, {4, 5, 6}, {}, {7}, {}, {}, {}, {8, 9}, {}, {}};
+        ListView view = {&children};
+        ariel::TreeLayout<size_t> layout;
+        ariel::layoutTree(view, sf::Vector2u(800, 600), layout);
+        REQUIRE(layout.size() == 10);
+        CHECK(layout.nodes[0].position == sf::Vector2f(400, ariel::RootTop));
+        CHECK(layout.nodes[1].position.y == ariel::RootTop + ariel::LevelSpacing);
+        CHECK(tidyLevels(layout));
+        for (size_t i = 0; i < layout.size(); ++i) {
+            std::vector<float> xs;
+            for (size_t j = 0; j < layout.size(); ++j) {
+                if (layout.nodes[j].parent == i) xs.push_back(layout.nodes[j].position.x);
+            }
+            if (!xs.empty()) {
+                CHECK(layout.nodes[i].position.x == doctest::Approx((xs.front() + xs.back()) / 2));
+            }
+        }
+    }
+
+    SUBCASE("Random trees") {
+        std::mt19937 random(7);
+        for (int round = 0; round < 20; ++round) {
+            std::vector<std::vector<size_t>> children(1);
+            for (size_t node = 1; node < 300; ++node) {
+                size_t parent;
+                do {
+                    parent = random() % node;
+                } while (children[parent].size() == 3);
+                children[parent].push_back(node);
+                children.emplace_back();
+            }
+            ListView view = {&children};
+            ariel::TreeLayout<size_t> layout;
+            ariel::layoutTree(view, sf::Vector2u(800, 600), layout);
+            REQUIRE(layout.size() == 300);
+            CHECK(tidyLevels(layout));
+        }
+    }
+
+    SUBCASE("Unary and wide trees") {
+        ariel::TreeLayout<size_t> layout;
+        ariel::layoutTree(KaryIndexView<1>{5}, sf::Vector2u(800, 600), layout);
+        REQUIRE(layout.size() == 5);
+        for (size_t i = 0; i < 5; ++i) {
+            CHECK(layout.nodes[i].position.x == 400);  // a chain is a straight line
+        }
+
+        ariel::layoutTree(KaryIndexView<5>{1 + 5 + 25}, sf::Vector2u(800, 600), layout);
+        REQUIRE(layout.size() == 31);
+        CHECK(tidyLevels(layout));
+        CHECK(layout.nodes[30].position.x - layout.nodes[6].position.x == doctest::Approx(24 * ariel::NodeSpacing));
+    }
+
+    SUBCASE("Deep tree - no recursion") {
+        ariel::TreeLayout<size_t> layout;
+        ariel::layoutTree(KaryIndexView<1>{200000}, sf::Vector2u(800, 600), layout);
+        CHECK(layout.size() == 200000);
+        CHECK(layout.nodes.back().position.x == 400);
+    }
+}
+
+TEST_CASE("LayoutIndex - nodes and edges inside a rectangle") {
+    std::mt19937 random(11);
+    std::vector<std::vector<size_t>> children(1);
+    for (size_t node = 1; node < 2000; ++node) {
+        size_t parent;
+        do {
+            parent = random() % node;
+        } while (children[parent].size() == 3);
+        children[parent].push_back(node);
+        children.emplace_back();
+    }
+    ListView view = {&children};
+    ariel::TreeLayout<size_t> layout;
+    ariel::layoutTree(view, sf::Vector2u(800, 600), layout);
+    ariel::LayoutIndex index;
+    index.build(layout);
+    REQUIRE(!index.levels().empty());
+    CHECK(index.levels().front().begin == 0);
+    CHECK(index.levels().back().end == layout.size());
+
+    std::vector<ariel::LayoutRange> nodes, edges;
+    for (int round = 0; round < 50; ++round) {
+        sf::FloatRect rect(static_cast<float>(random() % 4000) - 2000, static_cast<float>(random() % 1500), 300, 200);
+        index.query(layout, rect, ariel::NodeRadius, nodes, edges);
+
+        // Every node within the margin is found, and nothing else
+        std::vector<bool> found(layout.size(), false), foundEdge(layout.size(), false);
+        for (const ariel::LayoutRange& range : nodes) {
+            for (size_t i = range.begin; i < range.end; ++i) found[i] = true;
+        }
+        for (const ariel::LayoutRange& range : edges) {
+            for (size_t i = range.begin; i < range.end; ++i) foundEdge[i] = true;
+        }
+        sf::FloatRect grown(rect.left - ariel::NodeRadius, rect.top - ariel::NodeRadius, rect.width + 2 * ariel::NodeRadius, rect.height + 2 * ariel::NodeRadius);
+        size_t mismatches = 0, missedEdges = 0;
+        for (size_t i = 0; i < layout.size(); ++i) {
+            sf::Vector2f p = layout.nodes[i].position;
+            bool inside = p.x >= grown.left && p.x <= grown.left + grown.width && p.y >= grown.top && p.y <= grown.top + grown.height;
+            if (inside != found[i]) mismatches++;
+
+            // Every edge whose segment crosses the rectangle is a candidate - sampled along the segment
+            if (layout.nodes[i].parent != ariel::NoParent) {
+                sf::Vector2f q = layout.nodes[layout.nodes[i].parent].position;
+                for (int t = 0; t <= 16; ++t) {
+                    sf::Vector2f point = q + (p - q) * (t / 16.0f);
+                    if (rect.contains(point.x, point.y) && !foundEdge[i]) {
+                        missedEdges++;
+                        break;
+                    }
+                }
+            }
+        }
+        CHECK(mismatches == 0);
+        CHECK(missedEdges == 0);
+    }
+}
+
+TEST_CASE("LayoutIndex - subtree summaries and level of detail") {
+    std::vector<int> keys(1023);
+    VectorView view = {&keys};
+    ariel::TreeLayout<size_t> layout;
+    ariel::layoutTree(view, sf::Vector2u(800, 600), layout);
+    ariel::LayoutIndex index;
+    index.build(layout);
+
+    const std::vector<ariel::SubtreeSummary>& subtrees = index.subtrees();
+    REQUIRE(subtrees.size() == 1023);
+    CHECK(subtrees[0].count == 1023);
+    CHECK(subtrees[1].count == 511);
+    CHECK(subtrees[0].firstChild == 1);
+    CHECK(subtrees[0].children == 2);
+    CHECK(subtrees[1022].count == 1);
+    CHECK(subtrees[0].high.y == layout.nodes[1022].position.y);
+
+    sf::FloatRect everything(subtrees[0].low.x - 100, 0, subtrees[0].high.x - subtrees[0].low.x + 200, 2000);
+    ariel::DetailSelection selection;
+
+    SUBCASE("No subtree small enough - every node") {
+        index.select(layout, everything, ariel::NodeRadius, 1, selection);
+        CHECK(selection.nodes.size() == 1023);
+        CHECK(selection.aggregates.empty());
+        CHECK(selection.edges.size() == 1022);
+    }
+
+    SUBCASE("Whole tree below the threshold - one aggregate") {
+        index.select(layout, everything, ariel::NodeRadius, 1e9f, selection);
+        CHECK(selection.nodes.empty());
+        REQUIRE(selection.aggregates.size() == 1);
+        CHECK(selection.aggregates[0] == 0);
+    }
+
+    SUBCASE("Every node is drawn or inside exactly one aggregate") {
+        index.select(layout, everything, ariel::NodeRadius, 1000, selection);
+        CHECK(!selection.aggregates.empty());
+        CHECK(selection.nodes.size() + selection.aggregates.size() < 1023);
+        size_t covered = selection.nodes.size();
+        for (size_t root : selection.aggregates) covered += subtrees[root].count;
+        CHECK(covered == 1023);
+    }
+
+    SUBCASE("Subtrees outside the rectangle are skipped") {
+        sf::Vector2f leaf = layout.nodes[1022].position;
+        index.select(layout, sf::FloatRect(leaf.x - 5, leaf.y - 5, 10, 10), ariel::NodeRadius, 1, selection);
+        CHECK(selection.nodes.size() == 1);
+        CHECK(selection.nodes[0] == 1022);
+        CHECK(selection.pending.empty());
+    }
+}
+
+TEST_CASE("TreeRenderer - zoomed out subtrees are drawn as aggregates") {
+    std::vector<int> keys(5000);
+    VectorView view = {&keys};
+    ariel::TreeRenderer<VectorView> renderer;
+    sf::RenderTexture target;
+    target.create(800, 600);
+
+    // The whole tree in an 800 pixel wide target - far below AggregatePixels per subtree
+    target.setView(sf::View(sf::Vector2f(400, 400), sf::Vector2f(200000, 150000)));
+    renderer.draw(target, view);
+    const ariel::DetailSelection& detail = renderer.detail();
+    CHECK(!detail.aggregates.empty());
+    CHECK(detail.nodes.size() + detail.aggregates.size() < 500);
+    CHECK(renderer.geometry().triangles.getVertexCount() < 5000 * 3 * ariel::CirclePoints / 10);
+    CHECK(renderer.visible().empty());
+
+    // Zoomed in again - full detail through the row index
+    target.setView(sf::View(sf::Vector2f(400, 300), sf::Vector2f(800, 600)));
+    renderer.draw(target, view);
+    CHECK(renderer.detail().aggregates.empty());
+    CHECK(!renderer.visible().empty());
+    CHECK(renderer.layout_count() == 1);
+}
+
+TEST_CASE("TreeRenderer - only the nodes inside the view are built") {
+    std::vector<int> keys(1000);
+    VectorView view = {&keys};
+    ariel::TreeRenderer<VectorView> renderer;
+    sf::RenderTexture target;
+    target.create(800, 600);
+
+    // A view over the whole tree covers every node - drawn or inside an aggregate
+    target.setView(sf::View(sf::Vector2f(400, 400), sf::Vector2f(100000, 2000)));
+    renderer.draw(target, view);
+    size_t covered = renderer.detail().nodes.size();
+    for (size_t root : renderer.detail().aggregates) covered += renderer.index().subtrees()[root].count;
+    CHECK(covered == 1000);
+
+    // Zoom in on the root - a handful of nodes, the layout is not computed again
+    target.setView(sf::View(sf::Vector2f(400, 50), sf::Vector2f(200, 150)));
+    renderer.draw(target, view);
+    CHECK(renderer.layout_count() == 1);
+    size_t zoomed = renderer.geometry().triangles.getVertexCount();
+    CHECK(zoomed > 0);
+    CHECK(zoomed < 10 * 3 * ariel::CirclePoints);
+    size_t visible = 0;
+    for (const ariel::LayoutRange& range : renderer.visible()) visible += range.end - range.begin;
+    CHECK(zoomed == visible * 3 * ariel::CirclePoints);
+
+    // Pan far away from the tree - nothing to build
+    target.setView(sf::View(sf::Vector2f(100000, 100000), sf::Vector2f(800, 600)));
+    renderer.draw(target, view);
+    CHECK(renderer.geometry().triangles.getVertexCount() == 0);
+    CHECK(renderer.geometry().lines.getVertexCount() == 0);
+}
+
+TEST_CASE("RasterImage - primitives and file formats") {
+    ariel::RasterImage image(64, 32);
+    CHECK(image.width() == 64);
+    CHECK(image.height() == 32);
+    CHECK(image.pixel(0, 0).a == 255);
+    CHECK(image.pixel(0, 0).r == 0);
+
+    const ariel::RasterColor red = {255, 0, 0, 255};
+    image.fill_circle(10, 10, 4, red, image.bounds());
+    CHECK(image.pixel(10, 10).r == 255);
+    CHECK(image.pixel(10, 14).r == 0);
+    CHECK(image.pixel(15, 10).r == 0);
+
+    // Primitives stay inside the clip rectangle
+    image.draw_line(0, 20, 63, 20, red, ariel::PixelRect{0, 0, 32, 32});
+    CHECK(image.pixel(0, 20).r == 255);
+    CHECK(image.pixel(31, 20).r == 255);
+    CHECK(image.pixel(32, 20).r == 0);
+    image.draw_line(40, 0, 40, 100, red, image.bounds());
+    CHECK(image.pixel(40, 31).r == 255);
+
+    image.draw_text("1+2i", 0, 0, 1, red, image.bounds());
+    CHECK(ariel::RasterImage::text_width("1+2i", 2) == 46);
+    CHECK_THROWS_AS(image.pixel(64, 0), std::out_of_range);
+
+    std::ostringstream ppm;
+    image.write_ppm(ppm);
+    CHECK(ppm.str().substr(0, 13) == "P6\n64 32\n255\n");
+    CHECK(ppm.str().size() == 13 + 64 * 32 * 3);
+
+    std::ostringstream png;
+    image.write_png(png);
+    std::string bytes = png.str();
+    REQUIRE(bytes.size() > 33);
+    CHECK(bytes.substr(0, 8) == "\x89PNG\r\n\x1A\n");
+    CHECK(bytes.substr(12, 4) == "IHDR");
+    CHECK(static_cast<unsigned char>(bytes[19]) == 64);  // width, big-endian
+    CHECK(static_cast<unsigned char>(bytes[23]) == 32);  // height
+    CHECK(bytes.substr(bytes.size() - 8, 4) == "IEND");
+    CHECK(bytes.size() < 64 * 32 * 4 / 4);  // the background runs are compressed
+
+    CHECK_THROWS_AS(image.save("image.bmp"), std::invalid_argument);
+}
+
+TEST_CASE("Tree - headless rasterization") {
+    ariel::Tree<int> tree;
+    tree.add_root(1);
+    tree.add_sub_node(tree.get_root(), 2);
+    tree.add_sub_node(tree.get_root(), 3);
+    tree.add_sub_node(tree.get_root()->children[0], 4);
+
+    std::vector<int> keys = {1, 2, 3, 4};
+    VectorView view = {&keys};
+    ariel::TreeLayout<size_t> layout;
+    ariel::layoutTree(view, sf::Vector2u(800, 600), layout);
+
+    // The world rectangle of a default view - pixels are world units
+    ariel::RasterImage image(800, 600);
+    ariel::rasterizeTree(view, image, sf::FloatRect(0, 0, 800, 600), 1);
+    for (const ariel::LayoutNode& node : layout.nodes) {
+        ariel::RasterColor center = image.pixel(static_cast<unsigned>(node.position.x) + 10, static_cast<unsigned>(node.position.y) + 10);
+        CHECK(center.b == 255);  // inside the circle, away from the label and the edges
+    }
+    CHECK(image.pixel(5, 595).b == 0);
+
+    // Tiles on several threads give the same picture
+    ariel::RasterImage threaded(800, 600);
+    ariel::rasterizeTree(view, threaded, sf::FloatRect(0, 0, 800, 600), 4);
+    CHECK(std::equal(image.pixels(), image.pixels() + 800 * 600 * 4, threaded.pixels()));
+
+    // Scaled to fit - every node is drawn
+    ariel::RasterImage fitted(200, 100);
+    ariel::rasterizeTree(view, fitted, 2);
+    size_t blue = 0;
+    for (unsigned y = 0; y < 100; ++y) {
+        for (unsigned x = 0; x < 200; ++x) {
+            if (fitted.pixel(x, y).b == 255 && fitted.pixel(x, y).r == 0) blue++;
+        }
+    }
+    CHECK(blue > 0);
+
+    CHECK_THROWS_AS(tree.save_image("tree.gif", 100, 100), std::invalid_argument);
+}
+
+// Number of non-overlapping occurrences of a pattern in a text
+static size_t countOf(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + pattern.size())) count++;
+    return count;
+}
+
+TEST_CASE("Tree - SVG and DOT export") {
+    ariel::Tree<int, 3> tree;
+    for (int i = 0; i < 500; ++i) tree.push(i);  // a complete tree holding i at BFS index i
+
+    std::ostringstream svg;
+    tree.write_svg(svg);
+    std::string text = svg.str();
+    CHECK(text.compare(0, 5, "<?xml") == 0);
+    CHECK(countOf(text, "<circle ") == 500);
+    CHECK(countOf(text, "<path ") == 499);
+    CHECK(countOf(text, "<text ") == 500);
+    CHECK(text.find(">499</text>") != std::string::npos);
+    CHECK(text.substr(text.size() - 7) == "</svg>\n");
+
+    // The cached layout of the viewer is reused - the same document again, and after a drawn frame
+    std::ostringstream again;
+    tree.write_svg(again);
+    CHECK(again.str() == text);
+    sf::RenderTexture target;
+    target.create(800, 600);
+    tree.draw(target);
+    std::ostringstream drawn;
+    tree.write_svg(drawn);
+    CHECK(countOf(drawn.str(), "<circle ") == 500);
+
+    // Exports and frames of the same const tree on several threads take turns on the cached layout
+    const ariel::Tree<int, 3>& shared = tree;
+    std::vector<std::string> documents(2);
+    std::thread exporter([&]() {
+        for (std::string& document : documents) {
+            std::ostringstream out;
+            shared.write_svg(out);
+            document = out.str();
+        }
+    });
+    for (int frame = 0; frame < 4; ++frame) {
+        shared.build_geometry(sf::Vector2u(1024 + frame, 768), sf::View(sf::FloatRect(0, 0, 1024, 768)));
+    }
+    exporter.join();
+    for (const std::string& document : documents) {
+        CHECK(countOf(document, "<circle ") == 500);
+        CHECK(document.substr(document.size() - 7) == "</svg>\n");
+    }
+
+    std::ostringstream dot;
+    tree.write_dot(dot);
+    text = dot.str();
+    CHECK(text.compare(0, 14, "digraph Tree {") == 0);
+    CHECK(countOf(text, "[label=") == 500);
+    CHECK(countOf(text, " -> ") == 499);
+    CHECK(text.find("pos=") == std::string::npos);
+
+    // Nodes are named by their pre-order number - the same tree gives the same document in any copy and any run
+    ariel::Tree<int, 3> five, same;
+    for (int i = 0; i < 5; ++i) {
+        five.push(i);
+        same.push(i);
+    }
+    std::ostringstream smallDot, sameDot;
+    five.write_dot(smallDot);
+    same.write_dot(sameDot);
+    CHECK(smallDot.str() == "digraph Tree {\n"
+                            "node [shape=circle, style=filled, fillcolor=blue, fontcolor=white];\n"
+                            "n0 [label=\"0\"];\n"
+                            "n1 [label=\"1\"];\nn0 -> n1;\n"
+                            "n2 [label=\"4\"];\nn1 -> n2;\n"
+                            "n3 [label=\"2\"];\nn0 -> n3;\n"
+                            "n4 [label=\"3\"];\nn0 -> n4;\n"
+                            "}\n");
+    CHECK(sameDot.str() == smallDot.str());
+
+    // Keys are escaped for each format, floating point keys are printed like operator<<
+    ariel::Tree<std::string> words;
+    words.add_root("a<b & \"c\"");
+    std::ostringstream wordSvg, wordDot;
+    words.write_svg(wordSvg);
+    words.write_dot(wordDot);
+    CHECK(wordSvg.str().find(">a&lt;b &amp; &quot;c&quot;</text>") != std::string::npos);
+    CHECK(wordDot.str().find("label=\"a<b & \\\"c\\\"\"") != std::string::npos);
+
+    ariel::KeyFormatter format;
+    CHECK(format(0.1) == "0.1");
+    CHECK(format(1234567.0) == "1.23457e+06");
+    CHECK(format(-42) == "-42");
+    CHECK(format('x') == "x");
+    CHECK(format(Complex(1, 2)) == "1+2i");
+
+    // Writes larger than the buffer go straight to the stream, the rest in order on destruction
+    std::ostringstream small;
+    {
+        ariel::BufferedWriter writer(small, 64);
+        writer << "abc" << static_cast<size_t>(7) << ' ' << 1.5f;
+        writer << std::string(100, 'x');
+        writer << "end";
+        CHECK(small.str().size() == 108);  // "end" is still in the buffer
+    }
+    CHECK(small.str() == "abc7 1.5" + std::string(100, 'x') + "end");
+}
+
+TEST_CASE("TreeLayout - layout buffer, shapes and cached labels") {
+    std::vector<int> keys = {1, 2, 3, 4};
+    VectorView view = {&keys};
+
+    ariel::TreeLayout<size_t> layout;
+    ariel::layoutTree(view, sf::Vector2u(800, 600), layout);
+    REQUIRE(layout.size() == 4);
+    CHECK(layout.nodes[0].position == sf::Vector2f(400, 50));
+    CHECK(layout.nodes[0].parent == ariel::NoParent);
+    CHECK(layout.nodes[1].parent == 0);
+    CHECK(layout.nodes[2].parent == 0);  // BFS order: 1 2 3 4
+    CHECK(layout.nodes[3].parent == 1);
+    CHECK(layout.handles[3] == 3);
+
+    ariel::TreeGeometry geometry;
+    ariel::buildShapes(layout, geometry);
+    CHECK(geometry.triangles.getVertexCount() == 4 * 3 * ariel::CirclePoints);  // one triangle fan per node
+    CHECK(geometry.lines.getVertexCount() == 3 * 6);  // a line and two arrowhead lines per edge
+
+    ariel::LabelCache<size_t, int> labels;
+    ariel::buildLabels(layout, view, labels, geometry);
+    REQUIRE(labels.size() == 4);
+    CHECK(labels.get(0, 1).text == "1");
+    CHECK(labels.get(3, 4).text == "4");
+
+    // The next frame formats only the label whose key changed
+    labels.next_frame();
+    keys[2] = 30;
+    ariel::buildLabels(layout, view, labels, geometry);
+    CHECK(labels.formatted() == 5);
+    CHECK(labels.get(2, 30).text == "30");
+
+    geometry.clear();
+    CHECK(geometry.triangles.getVertexCount() == 0);
+    CHECK(geometry.glyphs.getVertexCount() == 0);
+}
+
+TEST_CASE("TreeRenderer - frames built without a font or a render target") {
+    // A font file nobody loaded - building a frame must not load it
+    const std::string fontPath = ariel::FontCache::default_path();
+    const std::string missing = "no-font-for-headless-frames.ttf";
+    ariel::FontCache::set_default_path(missing);
+
+    ariel::Tree<int, 3> tree;
+    for (int i = 0; i < 40; ++i) tree.push(i);  // key i at BFS index i
+
+    // The whole tree at full detail - one circle and one label per node, one arrow per edge
+    sf::View camera(sf::Vector2f(2000, 1500), sf::Vector2f(4000, 3000));
+    const ariel::TreeGeometry& geometry = tree.build_geometry(sf::Vector2u(4000, 3000), camera);
+    CHECK(geometry.triangles.getVertexCount() == 40 * 3 * ariel::CirclePoints);
+    CHECK(geometry.lines.getVertexCount() == 39 * 6);
+    REQUIRE(geometry.labels.size() == 40);
+    CHECK(geometry.labels[0].node == 0);
+    CHECK(geometry.labels[0].origin == sf::Vector2f(2000 - ariel::NodeRadius / 2, ariel::RootTop - ariel::NodeRadius / 2));
+    CHECK(geometry.labels[0].scale == 1);
+    CHECK(!geometry.labels[0].count);
+    REQUIRE(geometry.labels[0].label != nullptr);
+    CHECK(geometry.labels[0].label->text == "0");
+    CHECK(geometry.labels[39].label->text == "39");
+    CHECK(geometry.labels[39].label->glyphs.empty());
+    CHECK(geometry.glyphs.getVertexCount() == 0);
+    CHECK(geometry.glyphTexture == nullptr);
+
+    // Zoomed out - the collapsed subtrees get their node counts
+    sf::View far(sf::Vector2f(2000, 2000), sf::Vector2f(400000, 300000));
+    const ariel::TreeGeometry& overview = tree.build_geometry(sf::Vector2u(800, 600), far);
+    REQUIRE(!overview.labels.empty());
+    size_t counted = 0;
+    for (const ariel::LabelPlacement& label : overview.labels) {
+        CHECK(label.count);
+        CHECK(label.scale > 1);
+        CHECK(label.label->font == nullptr);
+        counted++;
+    }
+    CHECK(counted == overview.triangles.getVertexCount() / 6);  // a rectangle per collapsed subtree
+    CHECK(overview.labels[0].label->text == std::to_string(40));  // the whole tree collapses into the root
+
+    CHECK(!ariel::FontCache::is_cached(missing));
+    ariel::FontCache::set_default_path(fontPath);
+}
+
+TEST_CASE("TreeRenderer - submitting a built frame") {
+    ariel::TreeRenderer<VectorView> renderer;
+    std::vector<int> keys(40);
+    VectorView view = {&keys};
+    renderer.build(sf::Vector2u(800, 600), sf::View(sf::FloatRect(0, 0, 800, 600)), view);
+    size_t built = renderer.geometry().triangles.getVertexCount();
+    size_t placed = renderer.geometry().labels.size();
+    sf::RenderTexture target;
+    target.create(800, 600);
+    CHECK_NOTHROW(renderer.submit(target));
+    CHECK(renderer.geometry().glyphTexture == (ariel::FontCache::default_font() ? &ariel::FontCache::default_font()->getTexture(ariel::LabelSize) : nullptr));
+    renderer.draw(target, view);
+    CHECK(renderer.geometry().triangles.getVertexCount() == built);
+    CHECK(renderer.geometry().labels.size() == placed);
+    CHECK(renderer.layout_count() == 1);
+}
+
+TEST_CASE("TreeRenderer - layout computed only after changes") {
+    std::vector<int> keys = {1, 2, 3, 4, 5};
+    VectorView view = {&keys};
+    ariel::TreeRenderer<VectorView> renderer;
+    sf::RenderTexture target;
+    target.create(800, 600);
+
+    renderer.draw(target, view);
+    renderer.draw(target, view);
+    CHECK(renderer.layout_count() == 1);
+    CHECK(renderer.layout().size() == 5);
+
+    keys.push_back(6);
+    renderer.invalidate();
+    renderer.draw(target, view);
+    CHECK(renderer.layout_count() == 2);
+    CHECK(renderer.layout().size() == 6);
+
+    sf::RenderTexture bigger;
+    bigger.create(1024, 768);
+    if (bigger.getSize() != target.getSize()) {
+        renderer.draw(bigger, view);
+        CHECK(renderer.layout_count() == 3);  // a new target size needs a new layout
+    }
+}